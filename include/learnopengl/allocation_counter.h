@@ -0,0 +1,95 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// Per thread count of heap allocations, to check that loading doesn't copy more than it has to. The counting
+// replaces the global operator new, which has to happen in exactly one translation unit of the program:
+//
+//     #define ALLOCATION_COUNTER_IMPLEMENTATION
+//     #include <learnopengl/allocation_counter.h>
+//
+// Programs without it still compile, their counts just stay at zero.
+struct AllocationCounts {
+    size_t count;
+    size_t bytes;
+};
+
+// allocations made by the calling thread so far
+inline AllocationCounts &ThreadAllocations()
+{
+    static thread_local AllocationCounts counts = {0, 0};
+    return counts;
+}
+
+// allocations made by the calling thread since construction
+class AllocationScope
+{
+public:
+    AllocationScope() : start(ThreadAllocations())
+    {
+    }
+
+    size_t count() const { return ThreadAllocations().count - start.count; }
+    size_t bytes() const { return ThreadAllocations().bytes - start.bytes; }
+
+private:
+    AllocationCounts start;
+};
+
+#ifdef ALLOCATION_COUNTER_IMPLEMENTATION
+void *operator new(size_t size)
+{
+    AllocationCounts &counts = ThreadAllocations();
+    counts.count++;
+    counts.bytes += size;
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    try
+    {
+        return operator new(size);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    return operator new(size, std::nothrow);
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p, size_t) noexcept
+{
+    std::free(p);
+}
+#endif
+#endif
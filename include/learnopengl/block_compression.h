@@ -0,0 +1,468 @@
+#ifndef BLOCK_COMPRESSION_H
+#define BLOCK_COMPRESSION_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/ktx.h>
+#include <learnopengl/thread_pool.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BLOCK_COMPRESSION_SSE2
+#endif
+
+// Block compression (BC1/BC3/BC4/BC5, a.k.a. DXT1/DXT5/RGTC1/RGTC2) of texture mip chains on the CPU. Every 4x4
+// pixel block becomes 8 or 16 bytes, a quarter or less of the RGBA8 it replaces, and stays that small in VRAM.
+// Encoding is far too slow to do on every start, the texture loader stores the result in the .ktx cache.
+
+// S3TC is an extension in GL 3.3 (RGTC is core), glad doesn't define its enums
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+// data maps whose channels differ by at most this much everywhere count as grayscale and are stored in BC4
+const int GRAYSCALE_TOLERANCE = 8;
+
+// picks the compressed format for a texture from its usage and content (level 0), 0 keeps it uncompressed.
+// diffuse: BC1, or BC3 if it has alpha. specular/roughness: BC4 if grayscale, otherwise like diffuse.
+// normals: BC5 (x and y, z has to be reconstructed in the shader). BC1 and BC3 need s3tc.
+inline GLenum ChooseBlockFormat(const TextureLevels &texture, Texture_Usage usage, bool s3tc)
+{
+    if (usage == TEXTURE_NORMAL)
+        return GL_COMPRESSED_RG_RGTC2;
+
+    const TextureLevel &level = texture.levels[0];
+    unsigned int nrComponents = texture.nrComponents;
+    size_t row = KtxRowSize(level.width, nrComponents);
+    bool alpha = false;
+    bool grayscale = nrComponents == 1;
+    if (nrComponents >= 3)
+    {
+        grayscale = true;
+        for (unsigned int y = 0; y < level.height; y++)
+        {
+            const unsigned char *p = level.data + y * row;
+            for (unsigned int x = 0; x < level.width; x++, p += nrComponents)
+            {
+                if (std::abs(p[0] - p[1]) > GRAYSCALE_TOLERANCE || std::abs(p[0] - p[2]) > GRAYSCALE_TOLERANCE)
+                    grayscale = false;
+                if (nrComponents == 4 && p[3] != 255)
+                    alpha = true;
+            }
+        }
+    }
+
+    if (usage == TEXTURE_DATA && grayscale && !alpha)
+        return GL_COMPRESSED_RED_RGTC1;
+    if (!s3tc)
+        return 0;
+    return alpha ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+}
+
+inline unsigned int BlockBytes(GLenum format)
+{
+    return (format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT || format == GL_COMPRESSED_RED_RGTC1) ? 8 : 16;
+}
+
+inline unsigned int BlockFormatComponents(GLenum format)
+{
+    switch (format)
+    {
+        case GL_COMPRESSED_RED_RGTC1: return 1;
+        case GL_COMPRESSED_RG_RGTC2: return 2;
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT: return 4;
+        default: return 3;
+    }
+}
+
+// copies a 4x4 block as RGBA the way GL sees the uncompressed texture (missing channels 0, alpha 255),
+// so a compressed texture samples like the original. Blocks over the edge repeat the last row/column.
+inline void FetchBlock(const TextureLevel &level, unsigned int nrComponents, unsigned int bx, unsigned int by,
+                       unsigned char block[16][4])
+{
+    size_t row = KtxRowSize(level.width, nrComponents);
+    for (unsigned int y = 0; y < 4; y++)
+    {
+        unsigned int sy = std::min(by * 4 + y, level.height - 1);
+        for (unsigned int x = 0; x < 4; x++)
+        {
+            unsigned int sx = std::min(bx * 4 + x, level.width - 1);
+            const unsigned char *p = level.data + sy * row + sx * nrComponents;
+            unsigned char *out = block[y * 4 + x];
+            out[0] = p[0];
+            out[1] = nrComponents >= 2 ? p[1] : 0;
+            out[2] = nrComponents >= 3 ? p[2] : 0;
+            out[3] = nrComponents == 4 ? p[3] : 255;
+        }
+    }
+}
+
+// index of the closest palette color for each of the 16 pixels (2 bits each, pixel 0 lowest), sum of squared
+// distances in error. Pixels are given per channel.
+inline uint32_t MatchColorIndices(const float pixels[3][16], const float palette[4][3], float &error)
+{
+    uint32_t indices = 0;
+    error = 0.0f;
+#ifdef BLOCK_COMPRESSION_SSE2
+    for (int i = 0; i < 16; i += 4)
+    {
+        __m128 r = _mm_loadu_ps(pixels[0] + i), g = _mm_loadu_ps(pixels[1] + i), b = _mm_loadu_ps(pixels[2] + i);
+        __m128 best = _mm_set1_ps(1e30f);
+        __m128i bestIndex = _mm_setzero_si128();
+        for (int j = 0; j < 4; j++)
+        {
+            __m128 dr = _mm_sub_ps(r, _mm_set1_ps(palette[j][0]));
+            __m128 dg = _mm_sub_ps(g, _mm_set1_ps(palette[j][1]));
+            __m128 db = _mm_sub_ps(b, _mm_set1_ps(palette[j][2]));
+            __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)), _mm_mul_ps(db, db));
+            __m128i closer = _mm_castps_si128(_mm_cmplt_ps(d, best));
+            best = _mm_min_ps(d, best);
+            bestIndex = _mm_or_si128(_mm_andnot_si128(closer, bestIndex), _mm_and_si128(closer, _mm_set1_epi32(j)));
+        }
+        alignas(16) int32_t index[4];
+        alignas(16) float distance[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(index), bestIndex);
+        _mm_store_ps(distance, best);
+        for (int k = 0; k < 4; k++)
+        {
+            indices |= uint32_t(index[k]) << (2 * (i + k));
+            error += distance[k];
+        }
+    }
+#else
+    for (int i = 0; i < 16; i++)
+    {
+        float best = 1e30f;
+        uint32_t bestIndex = 0;
+        for (int j = 0; j < 4; j++)
+        {
+            float dr = pixels[0][i] - palette[j][0], dg = pixels[1][i] - palette[j][1], db = pixels[2][i] - palette[j][2];
+            float d = (dr * dr + dg * dg) + db * db;
+            if (d < best)
+            {
+                best = d;
+                bestIndex = j;
+            }
+        }
+        indices |= bestIndex << (2 * i);
+        error += best;
+    }
+#endif
+    return indices;
+}
+
+inline uint16_t PackRgb565(const float color[3])
+{
+    int r = std::min(31, std::max(0, (int)std::lround(color[0] * 31.0f / 255.0f)));
+    int g = std::min(63, std::max(0, (int)std::lround(color[1] * 63.0f / 255.0f)));
+    int b = std::min(31, std::max(0, (int)std::lround(color[2] * 31.0f / 255.0f)));
+    return uint16_t((r << 11) | (g << 5) | b);
+}
+
+inline void UnpackRgb565(uint16_t packed, float color[3])
+{
+    int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+    color[0] = float((r << 3) | (r >> 2));
+    color[1] = float((g << 2) | (g >> 4));
+    color[2] = float((b << 3) | (b >> 2));
+}
+
+struct ColorBlock {
+    uint16_t color0;
+    uint16_t color1;
+    uint32_t indices;
+    float error;
+};
+
+// quantizes two endpoints and assigns every pixel to the 4 color palette between them
+inline ColorBlock FitColorBlock(const float pixels[3][16], const float a[3], const float b[3])
+{
+    ColorBlock block;
+    block.color0 = PackRgb565(a);
+    block.color1 = PackRgb565(b);
+    // color0 > color1 selects the 4 color mode, the other order would mean 3 colors plus transparent black
+    if (block.color0 < block.color1)
+        std::swap(block.color0, block.color1);
+
+    float palette[4][3];
+    UnpackRgb565(block.color0, palette[0]);
+    UnpackRgb565(block.color1, palette[1]);
+    for (int c = 0; c < 3; c++)
+    {
+        palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+        palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+    }
+    if (block.color0 == block.color1)
+    {
+        // a single color, index 0 means color0 in either mode
+        for (int j = 1; j < 4; j++)
+            std::copy(palette[0], palette[0] + 3, palette[j]);
+        MatchColorIndices(pixels, palette, block.error);
+        block.indices = 0;
+        return block;
+    }
+    block.indices = MatchColorIndices(pixels, palette, block.error);
+    return block;
+}
+
+// BC1 color block: endpoints along the principal axis of the block's colors, then one least squares refit of
+// the endpoints to the chosen indices, keeping whichever of the two is closer
+inline void EncodeColorBlock(const unsigned char block[16][4], unsigned char out[8])
+{
+    float pixels[3][16];
+    float mean[3] = {0.0f, 0.0f, 0.0f};
+    for (int i = 0; i < 16; i++)
+        for (int c = 0; c < 3; c++)
+        {
+            pixels[c][i] = block[i][c];
+            mean[c] += block[i][c] / 16.0f;
+        }
+
+    float covariance[6] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+    for (int i = 0; i < 16; i++)
+    {
+        float r = pixels[0][i] - mean[0], g = pixels[1][i] - mean[1], b = pixels[2][i] - mean[2];
+        covariance[0] += r * r;
+        covariance[1] += r * g;
+        covariance[2] += r * b;
+        covariance[3] += g * g;
+        covariance[4] += g * b;
+        covariance[5] += b * b;
+    }
+    // principal axis by power iteration
+    float axis[3] = {0.9f, 1.0f, 0.7f};
+    for (int iteration = 0; iteration < 4; iteration++)
+    {
+        float x = axis[0] * covariance[0] + axis[1] * covariance[1] + axis[2] * covariance[2];
+        float y = axis[0] * covariance[1] + axis[1] * covariance[3] + axis[2] * covariance[4];
+        float z = axis[0] * covariance[2] + axis[1] * covariance[4] + axis[2] * covariance[5];
+        float length = std::max(std::fabs(x), std::max(std::fabs(y), std::fabs(z)));
+        if (length < 1e-6f)
+            break;
+        axis[0] = x / length;
+        axis[1] = y / length;
+        axis[2] = z / length;
+    }
+
+    int minIndex = 0, maxIndex = 0;
+    float minDot = 1e30f, maxDot = -1e30f;
+    for (int i = 0; i < 16; i++)
+    {
+        float dot = pixels[0][i] * axis[0] + pixels[1][i] * axis[1] + pixels[2][i] * axis[2];
+        if (dot < minDot)
+        {
+            minDot = dot;
+            minIndex = i;
+        }
+        if (dot > maxDot)
+        {
+            maxDot = dot;
+            maxIndex = i;
+        }
+    }
+    float a[3] = {pixels[0][maxIndex], pixels[1][maxIndex], pixels[2][maxIndex]};
+    float b[3] = {pixels[0][minIndex], pixels[1][minIndex], pixels[2][minIndex]};
+    ColorBlock best = FitColorBlock(pixels, a, b);
+
+    if (best.error > 0.0f && best.color0 != best.color1)
+    {
+        // least squares endpoints for the current indices: pixel ~ w * color0 + (1 - w) * color1
+        static const float weights[4] = {1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f};
+        float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+        float ap[3] = {0.0f, 0.0f, 0.0f}, bp[3] = {0.0f, 0.0f, 0.0f};
+        for (int i = 0; i < 16; i++)
+        {
+            float w = weights[(best.indices >> (2 * i)) & 3], v = 1.0f - w;
+            aa += w * w;
+            ab += w * v;
+            bb += v * v;
+            for (int c = 0; c < 3; c++)
+            {
+                ap[c] += w * pixels[c][i];
+                bp[c] += v * pixels[c][i];
+            }
+        }
+        float determinant = aa * bb - ab * ab;
+        if (std::fabs(determinant) > 1e-6f)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                a[c] = std::min(255.0f, std::max(0.0f, (ap[c] * bb - bp[c] * ab) / determinant));
+                b[c] = std::min(255.0f, std::max(0.0f, (bp[c] * aa - ap[c] * ab) / determinant));
+            }
+            ColorBlock refined = FitColorBlock(pixels, a, b);
+            if (refined.error < best.error)
+                best = refined;
+        }
+    }
+
+    out[0] = best.color0 & 0xFF;
+    out[1] = best.color0 >> 8;
+    out[2] = best.color1 & 0xFF;
+    out[3] = best.color1 >> 8;
+    for (int i = 0; i < 4; i++)
+        out[4 + i] = (best.indices >> (8 * i)) & 0xFF;
+}
+
+// index of the closest palette value for each of the 16 values
+inline void MatchValueIndices(const unsigned char values[16], const int palette[8], unsigned char indices[16])
+{
+#ifdef BLOCK_COMPRESSION_SSE2
+    __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values));
+    __m128i halves[2] = {_mm_unpacklo_epi8(bytes, _mm_setzero_si128()), _mm_unpackhi_epi8(bytes, _mm_setzero_si128())};
+    __m128i result[2];
+    for (int h = 0; h < 2; h++)
+    {
+        __m128i best = _mm_set1_epi16(0x7FFF);
+        __m128i bestIndex = _mm_setzero_si128();
+        for (int j = 0; j < 8; j++)
+        {
+            __m128i d = _mm_sub_epi16(halves[h], _mm_set1_epi16((short)palette[j]));
+            d = _mm_max_epi16(d, _mm_sub_epi16(_mm_setzero_si128(), d));
+            __m128i closer = _mm_cmplt_epi16(d, best);
+            best = _mm_min_epi16(d, best);
+            bestIndex = _mm_or_si128(_mm_andnot_si128(closer, bestIndex), _mm_and_si128(closer, _mm_set1_epi16((short)j)));
+        }
+        result[h] = bestIndex;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(indices), _mm_packus_epi16(result[0], result[1]));
+#else
+    for (int i = 0; i < 16; i++)
+    {
+        int best = 0x7FFF;
+        for (int j = 0; j < 8; j++)
+        {
+            int d = std::abs(values[i] - palette[j]);
+            if (d < best)
+            {
+                best = d;
+                indices[i] = (unsigned char)j;
+            }
+        }
+    }
+#endif
+}
+
+// BC4 block of a single channel (also the alpha half of BC3 and both halves of BC5): the value range of the
+// block in 8 steps, 3 bits per pixel
+inline void EncodeValueBlock(const unsigned char values[16], unsigned char out[8])
+{
+    int low = 255, high = 0;
+    for (int i = 0; i < 16; i++)
+    {
+        low = std::min(low, (int)values[i]);
+        high = std::max(high, (int)values[i]);
+    }
+    // value0 > value1 selects the 8 step mode
+    out[0] = (unsigned char)high;
+    out[1] = (unsigned char)low;
+
+    unsigned char indices[16] = {0};
+    if (high > low)
+    {
+        int palette[8] = {high, low};
+        for (int j = 2; j < 8; j++)
+            palette[j] = ((8 - j) * high + (j - 1) * low + 3) / 7;
+        MatchValueIndices(values, palette, indices);
+    }
+    uint64_t bits = 0;
+    for (int i = 0; i < 16; i++)
+        bits |= uint64_t(indices[i]) << (3 * i);
+    for (int i = 0; i < 6; i++)
+        out[2 + i] = (bits >> (8 * i)) & 0xFF;
+}
+
+inline void EncodeBlock(GLenum format, const unsigned char block[16][4], unsigned char *out)
+{
+    unsigned char channel[16];
+    switch (format)
+    {
+        case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
+            EncodeColorBlock(block, out);
+            break;
+        case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+            for (int i = 0; i < 16; i++)
+                channel[i] = block[i][3];
+            EncodeValueBlock(channel, out);
+            EncodeColorBlock(block, out + 8);
+            break;
+        case GL_COMPRESSED_RED_RGTC1:
+            for (int i = 0; i < 16; i++)
+                channel[i] = block[i][0];
+            EncodeValueBlock(channel, out);
+            break;
+        case GL_COMPRESSED_RG_RGTC2:
+            for (int c = 0; c < 2; c++)
+            {
+                for (int i = 0; i < 16; i++)
+                    channel[i] = block[i][c];
+                EncodeValueBlock(channel, out + 8 * c);
+            }
+            break;
+    }
+}
+
+// block rows encoded per task, small enough to spread the big levels over every thread
+const unsigned int BLOCK_ROWS_PER_TASK = 8;
+
+// compresses every level of an uncompressed 8-bit mip chain. The work is split in runs of block rows and spread
+// over pool (if any), the calling thread waits for the result.
+inline TextureLevels CompressTextureLevels(const TextureLevels &source, GLenum format, ThreadPool *pool = nullptr)
+{
+    TextureLevels result;
+    result.internalFormat = format;
+    result.nrComponents = BlockFormatComponents(format);
+    result.keyValues = source.keyValues;
+
+    unsigned int blockBytes = BlockBytes(format);
+    size_t total = 0;
+    for (const TextureLevel &level : source.levels)
+        total += size_t((level.width + 3) / 4) * ((level.height + 3) / 4) * blockBytes;
+    result.storage = std::make_shared<std::vector<unsigned char>>(total);
+
+    struct Task {
+        size_t level;
+        unsigned int firstRow;
+        unsigned int rowCount;
+    };
+    std::vector<Task> tasks;
+    std::vector<size_t> offsets;
+    size_t offset = 0;
+    for (size_t l = 0; l < source.levels.size(); l++)
+    {
+        const TextureLevel &level = source.levels[l];
+        unsigned int blocksX = (level.width + 3) / 4, blocksY = (level.height + 3) / 4;
+        size_t size = size_t(blocksX) * blocksY * blockBytes;
+        result.levels.push_back(TextureLevel{level.width, level.height, result.storage->data() + offset, size});
+        offsets.push_back(offset);
+        offset += size;
+        for (unsigned int row = 0; row < blocksY; row += BLOCK_ROWS_PER_TASK)
+            tasks.push_back(Task{l, row, std::min(BLOCK_ROWS_PER_TASK, blocksY - row)});
+    }
+
+    ParallelFor(pool, tasks.size(), [&](size_t t) {
+        const Task &task = tasks[t];
+        const TextureLevel &level = source.levels[task.level];
+        unsigned int blocksX = (level.width + 3) / 4;
+        unsigned char *out = result.storage->data() + offsets[task.level] + size_t(task.firstRow) * blocksX * blockBytes;
+        unsigned char block[16][4];
+        for (unsigned int by = task.firstRow; by < task.firstRow + task.rowCount; by++)
+            for (unsigned int bx = 0; bx < blocksX; bx++, out += blockBytes)
+            {
+                FetchBlock(level, source.nrComponents, bx, by, block);
+                EncodeBlock(format, block, out);
+            }
+    });
+    return result;
+}
+#endif
@@ -0,0 +1,197 @@
+#ifndef FILE_WATCHER_H
+#define FILE_WATCHER_H
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Reports files that were written below the watched directories, so the viewer can reload them while it runs
+// (see ModelStreamer::reload, TextureRegistry::reload). A thread blocks on inotify and collects the changes; the GL
+// thread picks them up with changes() once per frame.
+//
+// Editors save in several steps (truncate and write, or write a temporary file and rename it over the old one), so
+// a file is only reported once FILE_WATCHER_SETTLE_MS passed without another event for it. Without inotify (other
+// systems than Linux) nothing is ever reported.
+//
+//     FileWatcher watcher;
+//     watcher.watch("resources/objects");
+//     ...
+//     for (const std::string &path : watcher.changes())
+//         ...     // "resources/objects/Armchair/Armchair.mtl"
+
+// quiet time after the last event for a file before it counts as changed
+const int FILE_WATCHER_SETTLE_MS = 150;
+// how long the thread waits for events before it looks at the settling files again (and at whether to stop)
+const int FILE_WATCHER_POLL_MS = 50;
+
+class FileWatcher
+{
+public:
+    FileWatcher() : fd(-1), stopping(false)
+    {
+#ifdef __linux__
+        fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (fd < 0)
+            std::cout << "WARNING::FILE_WATCHER:: inotify is not available, changed files won't be reloaded" << std::endl;
+#endif
+    }
+
+    FileWatcher(const FileWatcher &) = delete;
+    FileWatcher &operator=(const FileWatcher &) = delete;
+
+    ~FileWatcher()
+    {
+        stopping = true;
+        if (thread.joinable())
+            thread.join();
+#ifdef __linux__
+        if (fd >= 0)
+            close(fd);
+#endif
+    }
+
+    // watches directory and every directory below it, including ones created later. Paths are reported spelled the
+    // way directory is. Returns false if it can't be watched.
+    bool watch(const std::string &directory)
+    {
+#ifdef __linux__
+        if (fd < 0 || !addWatches(directory))
+            return false;
+        if (!thread.joinable())
+            thread = std::thread([this]() { run(); });
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // GL thread, once per frame: the files that changed since the last call, each once
+    std::vector<std::string> changes()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<std::string> result;
+        result.swap(settled);
+        return result;
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    int fd;
+    std::atomic<bool> stopping;
+    std::thread thread;
+    std::mutex mutex;
+    std::map<int, std::string> directories;         // watch descriptor -> directory
+    std::map<std::string, Clock::time_point> settling;  // watcher thread only: path -> time of its last event
+    std::vector<std::string> settled;
+
+#ifdef __linux__
+    bool addWatches(const std::string &directory)
+    {
+        int wd = inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR);
+        if (wd < 0)
+        {
+            std::cout << "WARNING::FILE_WATCHER:: can't watch " << directory << std::endl;
+            return false;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            directories[wd] = directory;
+        }
+        DIR *dir = opendir(directory.c_str());
+        if (!dir)
+            return true;
+        while (dirent *entry = readdir(dir))
+        {
+            if (entry->d_name[0] == '.')
+                continue;
+            std::string path = directory + '/' + entry->d_name;
+            struct stat st;
+            if (stat(path.c_str(), &st) == 0 && S_ISDIR(st.st_mode))
+                addWatches(path);
+        }
+        closedir(dir);
+        return true;
+    }
+
+    void run()
+    {
+        // large enough for a burst of events, every event is followed by its name
+        alignas(inotify_event) char buffer[16 * 1024];
+        while (!stopping)
+        {
+            pollfd request = {fd, POLLIN, 0};
+            if (poll(&request, 1, FILE_WATCHER_POLL_MS) > 0)
+            {
+                ssize_t length;
+                while ((length = read(fd, buffer, sizeof(buffer))) > 0)
+                {
+                    for (char *p = buffer; p < buffer + length; )
+                    {
+                        const inotify_event *event = reinterpret_cast<const inotify_event*>(p);
+                        p += sizeof(inotify_event) + event->len;
+                        handle(*event);
+                    }
+                }
+            }
+
+            // hand on the files that have been quiet long enough
+            Clock::time_point now = Clock::now();
+            std::vector<std::string> quiet;
+            for (auto it = settling.begin(); it != settling.end(); )
+            {
+                if (now - it->second >= std::chrono::milliseconds(FILE_WATCHER_SETTLE_MS))
+                {
+                    quiet.push_back(it->first);
+                    it = settling.erase(it);
+                }
+                else
+                    ++it;
+            }
+            if (!quiet.empty())
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                for (std::string &path : quiet)
+                    if (std::find(settled.begin(), settled.end(), path) == settled.end())
+                        settled.push_back(std::move(path));
+            }
+        }
+    }
+
+    void handle(const inotify_event &event)
+    {
+        if (event.len == 0 || event.name[0] == '.')
+            return;     // the directory itself, or hidden files like editor swap files
+        std::string path;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto directory = directories.find(event.wd);
+            if (directory == directories.end())
+                return;
+            path = directory->second + '/' + event.name;
+        }
+        if (event.mask & IN_ISDIR)
+        {
+            if (event.mask & (IN_CREATE | IN_MOVED_TO))
+                addWatches(path);
+        }
+        else if (event.mask & (IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE))
+            settling[path] = Clock::now();
+    }
+#endif
+};
+#endif
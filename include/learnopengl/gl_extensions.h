@@ -0,0 +1,69 @@
+#ifndef GL_EXTENSIONS_H
+#define GL_EXTENSIONS_H
+
+#include <glad/glad.h>
+
+#include <cstring>
+
+// true if the current context advertises the given extension, e.g. "GL_EXT_texture_compression_s3tc".
+// Our glad loader is generated for core 3.3 without extensions, so anything optional has to be checked here.
+// GL thread only.
+inline bool HasExtension(const char *name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++)
+    {
+        const char *extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        if (extension && strcmp(extension, name) == 0)
+            return true;
+    }
+    return false;
+}
+
+// the function glad was loaded with (glfwGetProcAddress in main.cpp), kept for the entry points of extensions
+// glad doesn't know about. Set it with SetExtensionLoader right after gladLoadGLLoader.
+inline GLADloadproc &ExtensionLoader()
+{
+    static GLADloadproc loader = nullptr;
+    return loader;
+}
+
+inline void SetExtensionLoader(GLADloadproc loader)
+{
+    ExtensionLoader() = loader;
+}
+
+// address of an extension function, nullptr if there is no loader or the driver doesn't have it
+template <typename Function>
+inline Function LoadExtensionFunction(const char *name)
+{
+    return ExtensionLoader() ? reinterpret_cast<Function>(ExtensionLoader()(name)) : nullptr;
+}
+
+// KHR_parallel_shader_compile (and the identical ARB version)
+#ifndef GL_MAX_SHADER_COMPILER_THREADS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#define GL_COMPLETION_STATUS_KHR           0x91B1
+#endif
+typedef void (APIENTRYP PFNGLMAXSHADERCOMPILERTHREADSKHRPROC)(GLuint count);
+
+// GL thread: true if compiles and links run on the driver's threads, so GL_COMPLETION_STATUS_KHR can be polled
+// instead of blocking on the status. Asks the driver for as many compiler threads as it likes the first time (if
+// SetExtensionLoader was called, the default count is up to the driver otherwise).
+inline bool ParallelShaderCompile()
+{
+    static int available = -1;
+    if (available < 0)
+    {
+        bool khr = HasExtension("GL_KHR_parallel_shader_compile");
+        available = khr || HasExtension("GL_ARB_parallel_shader_compile");
+        PFNGLMAXSHADERCOMPILERTHREADSKHRPROC maxThreads = nullptr;
+        if (available)
+            maxThreads = LoadExtensionFunction<PFNGLMAXSHADERCOMPILERTHREADSKHRPROC>(khr ? "glMaxShaderCompilerThreadsKHR" : "glMaxShaderCompilerThreadsARB");
+        if (maxThreads)
+            maxThreads(0xFFFFFFFF);
+    }
+    return available > 0;
+}
+#endif
@@ -0,0 +1,80 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// 64-bit FNV-1a, used to key on-disk caches by the content of their source files.
+constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+constexpr uint64_t FNV_PRIME        = 1099511628211ULL;
+
+inline uint64_t HashBytes(const void *data, size_t size, uint64_t seed = FNV_OFFSET_BASIS)
+{
+    const unsigned char *bytes = static_cast<const unsigned char*>(data);
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+// variant for whole files (images, meshes): mixes 8 bytes per step, which is several times faster than
+// HashBytes on multi-megabyte inputs. Not interchangeable with HashBytes, the results differ.
+inline uint64_t HashContent(const void *data, size_t size)
+{
+    const unsigned char *bytes = static_cast<const unsigned char*>(data);
+    uint64_t hash = FNV_OFFSET_BASIS ^ size;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+    {
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof(word));
+        hash ^= word;
+        hash *= FNV_PRIME;
+        hash ^= hash >> 32;
+    }
+    return HashBytes(bytes + i, size - i, hash);
+}
+
+// HashBytes of a zero terminated string, usable in constant expressions: names known at compile time (uniforms,
+// texture types) become constants, constexpr uint64_t id = HashName("texture_diffuse")
+constexpr uint64_t HashName(const char *name, uint64_t seed = FNV_OFFSET_BASIS)
+{
+    uint64_t hash = seed;
+    for (; *name; name++)
+    {
+        hash ^= static_cast<unsigned char>(*name);
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+inline uint64_t HashString(const std::string &str, uint64_t seed = FNV_OFFSET_BASIS)
+{
+    return HashBytes(str.data(), str.size(), seed);
+}
+
+// folds a plain value (flags, version numbers...) into an existing hash
+template <typename T>
+inline uint64_t HashValue(const T &value, uint64_t seed = FNV_OFFSET_BASIS)
+{
+    return HashBytes(&value, sizeof(T), seed);
+}
+
+// formats a hash as a fixed width hex string, handy for cache file names
+inline std::string HashToString(uint64_t hash)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string result(16, '0');
+    for (int i = 15; i >= 0; i--)
+    {
+        result[i] = digits[hash & 0xF];
+        hash >>= 4;
+    }
+    return result;
+}
+#endif
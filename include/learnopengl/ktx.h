@@ -0,0 +1,348 @@
+#ifndef KTX_H
+#define KTX_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/mapped_file.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Textures with their complete mip chain, stored in KTX 1.1 files (https://registry.khronos.org/KTX/specs/1.0/ktxspec_v1.html).
+// The texture loader converts every source image once, later runs map the .ktx file and upload each level from the
+// mapping directly, skipping both the PNG/JPEG decode and glGenerateMipmap.
+
+// what a texture holds. Decides how its mip chain is filtered: color maps are averaged in linear space so the
+// smaller levels don't get darker, data maps (specular, roughness...) and normal maps are averaged as they are.
+// Also picks the block compression format, see ChooseBlockFormat.
+enum Texture_Usage {
+    TEXTURE_COLOR,
+    TEXTURE_DATA,
+    TEXTURE_NORMAL
+};
+
+struct TextureLevel {
+    unsigned int width;
+    unsigned int height;
+    const unsigned char *data;
+    size_t size;
+};
+
+// a texture ready for upload: every level plus the GL formats describing them. The level data either lives in
+// storage or in a mapped file, both are kept alive by this object.
+struct TextureLevels {
+    GLenum internalFormat = 0;
+    GLenum format = 0;          // 0 for compressed textures
+    GLenum type = 0;            // 0 for compressed textures
+    unsigned int nrComponents = 0;
+    std::vector<TextureLevel> levels;
+    std::vector<std::pair<std::string, std::string>> keyValues;
+
+    std::shared_ptr<std::vector<unsigned char>> storage;
+    std::shared_ptr<MappedFile> file;
+
+    bool compressed() const { return format == 0; }
+};
+
+// KTX rows (and GL's default GL_UNPACK_ALIGNMENT) are padded to 4 bytes
+inline size_t KtxRowSize(unsigned int width, unsigned int nrComponents)
+{
+    return (size_t(width) * nrComponents + 3) & ~size_t(3);
+}
+
+inline GLenum FormatForComponents(unsigned int nrComponents)
+{
+    switch (nrComponents)
+    {
+        case 1: return GL_RED;
+        case 2: return GL_RG;
+        case 4: return GL_RGBA;
+        default: return GL_RGB;
+    }
+}
+
+inline float SrgbToLinear(float c)
+{
+    return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+inline float LinearToSrgb(float c)
+{
+    return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+}
+
+// builds the full mip chain (down to 1x1) of a tightly packed 8-bit image with a 2x2 box filter.
+// for TEXTURE_COLOR the color channels are filtered in linear space, alpha always stays linear.
+inline TextureLevels GenerateMipChain(const unsigned char *pixels, unsigned int width, unsigned int height,
+                                      unsigned int nrComponents, Texture_Usage usage)
+{
+    static float toLinear[256];
+    static unsigned char toSrgb[4096];
+    static bool tablesReady = [] {
+        for (int i = 0; i < 256; i++)
+            toLinear[i] = SrgbToLinear(i / 255.0f);
+        for (int i = 0; i < 4096; i++)
+            toSrgb[i] = (unsigned char)std::lround(LinearToSrgb(i / 4095.0f) * 255.0f);
+        return true;
+    }();
+    (void)tablesReady;
+
+    TextureLevels result;
+    result.nrComponents = nrComponents;
+    result.format = FormatForComponents(nrComponents);
+    result.internalFormat = result.format;
+    result.type = GL_UNSIGNED_BYTE;
+
+    // level sizes first, so the storage is allocated once and level pointers stay valid
+    std::vector<std::pair<unsigned int, unsigned int>> sizes;
+    size_t total = 0;
+    for (unsigned int w = width, h = height; ; w = std::max(1u, w / 2), h = std::max(1u, h / 2))
+    {
+        sizes.push_back(std::make_pair(w, h));
+        total += KtxRowSize(w, nrComponents) * h;
+        if (w == 1 && h == 1)
+            break;
+    }
+    result.storage = std::make_shared<std::vector<unsigned char>>(total);
+    unsigned char *out = result.storage->data();
+
+    // level 0 is the source image with padded rows
+    size_t srcRow = size_t(width) * nrComponents;
+    size_t dstRow = KtxRowSize(width, nrComponents);
+    for (unsigned int y = 0; y < height; y++)
+        memcpy(out + y * dstRow, pixels + y * srcRow, srcRow);
+    result.levels.push_back(TextureLevel{width, height, out, dstRow * height});
+
+    unsigned int alphaChannel = (nrComponents == 2 || nrComponents == 4) ? nrComponents - 1 : nrComponents;
+    size_t offset = dstRow * height;
+    for (size_t l = 1; l < sizes.size(); l++)
+    {
+        const TextureLevel prev = result.levels.back();
+        size_t prevRow = KtxRowSize(prev.width, nrComponents);
+        unsigned int w = sizes[l].first, h = sizes[l].second;
+        size_t row = KtxRowSize(w, nrComponents);
+        unsigned char *dst = out + offset;
+
+        for (unsigned int y = 0; y < h; y++)
+        {
+            unsigned int y0 = std::min(2 * y, prev.height - 1), y1 = std::min(2 * y + 1, prev.height - 1);
+            for (unsigned int x = 0; x < w; x++)
+            {
+                unsigned int x0 = std::min(2 * x, prev.width - 1), x1 = std::min(2 * x + 1, prev.width - 1);
+                const unsigned char *p[4] = {
+                    prev.data + y0 * prevRow + x0 * nrComponents, prev.data + y0 * prevRow + x1 * nrComponents,
+                    prev.data + y1 * prevRow + x0 * nrComponents, prev.data + y1 * prevRow + x1 * nrComponents
+                };
+                for (unsigned int c = 0; c < nrComponents; c++)
+                {
+                    unsigned char value;
+                    if (usage == TEXTURE_COLOR && c != alphaChannel)
+                    {
+                        float linear = (toLinear[p[0][c]] + toLinear[p[1][c]] + toLinear[p[2][c]] + toLinear[p[3][c]]) * 0.25f;
+                        value = toSrgb[(int)(linear * 4095.0f + 0.5f)];
+                    }
+                    else
+                        value = (unsigned char)((p[0][c] + p[1][c] + p[2][c] + p[3][c] + 2) / 4);
+                    dst[y * row + x * nrComponents + c] = value;
+                }
+            }
+        }
+        result.levels.push_back(TextureLevel{w, h, dst, row * h});
+        offset += row * h;
+    }
+    return result;
+}
+
+// KTX 1.1 file layout
+const unsigned char KTX_IDENTIFIER[12] = {0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'};
+const uint32_t KTX_ENDIANNESS = 0x04030201;
+
+struct KtxHeader {
+    unsigned char identifier[12];
+    uint32_t endianness;
+    uint32_t glType;
+    uint32_t glTypeSize;
+    uint32_t glFormat;
+    uint32_t glInternalFormat;
+    uint32_t glBaseInternalFormat;
+    uint32_t pixelWidth;
+    uint32_t pixelHeight;
+    uint32_t pixelDepth;
+    uint32_t numberOfArrayElements;
+    uint32_t numberOfFaces;
+    uint32_t numberOfMipmapLevels;
+    uint32_t bytesOfKeyValueData;
+};
+
+inline size_t KtxPad4(size_t size)
+{
+    return (size + 3) & ~size_t(3);
+}
+
+// the levels as the bytes of a KTX file, empty if there are no levels
+inline std::string SerializeKtx(const TextureLevels &texture)
+{
+    if (texture.levels.empty())
+        return std::string();
+
+    std::string keyValueData;
+    for (const auto &kv : texture.keyValues)
+    {
+        // key and value are both null terminated strings, the pair is padded to 4 bytes
+        std::string pair = kv.first + '\0' + kv.second + '\0';
+        uint32_t size = pair.size();
+        keyValueData.append(reinterpret_cast<const char*>(&size), sizeof(size));
+        keyValueData.append(pair);
+        keyValueData.resize(KtxPad4(keyValueData.size()), '\0');
+    }
+
+    KtxHeader header;
+    memcpy(header.identifier, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER));
+    header.endianness = KTX_ENDIANNESS;
+    header.glType = texture.type;
+    header.glTypeSize = 1;
+    header.glFormat = texture.format;
+    header.glInternalFormat = texture.internalFormat;
+    header.glBaseInternalFormat = texture.compressed() ? FormatForComponents(texture.nrComponents) : texture.format;
+    header.pixelWidth = texture.levels[0].width;
+    header.pixelHeight = texture.levels[0].height;
+    header.pixelDepth = 0;
+    header.numberOfArrayElements = 0;
+    header.numberOfFaces = 1;
+    header.numberOfMipmapLevels = texture.levels.size();
+    header.bytesOfKeyValueData = keyValueData.size();
+
+    std::string blob(reinterpret_cast<const char*>(&header), sizeof(header));
+    blob.append(keyValueData);
+    for (const TextureLevel &level : texture.levels)
+    {
+        uint32_t imageSize = level.size;
+        blob.append(reinterpret_cast<const char*>(&imageSize), sizeof(imageSize));
+        blob.append(reinterpret_cast<const char*>(level.data), level.size);
+        blob.resize(KtxPad4(blob.size()), '\0');
+    }
+    return blob;
+}
+
+// writes the levels as a KTX file (atomically, see WriteFileAtomic)
+inline bool WriteKtx(const std::string &path, const TextureLevels &texture)
+{
+    std::string blob = SerializeKtx(texture);
+    return !blob.empty() && WriteFileAtomic(path, blob.data(), blob.size());
+}
+
+// reads a KTX file written by WriteKtx from size bytes at data, which lie inside the mapping file (a .ktx of its
+// own or a scene pack). Level data points into the mapping, nothing is copied; texture keeps file alive.
+inline bool ParseKtx(const std::shared_ptr<MappedFile> &file, const unsigned char *data, size_t size, TextureLevels &texture)
+{
+    if (size < sizeof(KtxHeader))
+        return false;
+
+    KtxHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.identifier, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER)) != 0 || header.endianness != KTX_ENDIANNESS
+        || header.numberOfFaces != 1 || header.pixelDepth != 0 || header.numberOfMipmapLevels == 0)
+        return false;
+
+    size_t offset = sizeof(KtxHeader);
+    size_t end = offset + header.bytesOfKeyValueData;
+    if (end > size)
+        return false;
+    texture.keyValues.clear();
+    while (offset + sizeof(uint32_t) <= end)
+    {
+        uint32_t pairSize;
+        memcpy(&pairSize, data + offset, sizeof(pairSize));
+        offset += sizeof(pairSize);
+        if (offset + pairSize > end)
+            return false;
+        const char *pair = reinterpret_cast<const char*>(data + offset);
+        std::string key(pair, strnlen(pair, pairSize));
+        std::string value;
+        if (key.size() + 1 < pairSize)
+            value.assign(pair + key.size() + 1, strnlen(pair + key.size() + 1, pairSize - key.size() - 1));
+        texture.keyValues.push_back(std::make_pair(key, value));
+        offset = KtxPad4(offset + pairSize);
+    }
+    offset = end;
+
+    texture.internalFormat = header.glInternalFormat;
+    texture.format = header.glFormat;
+    texture.type = header.glType;
+    switch (header.glBaseInternalFormat)
+    {
+        case GL_RED: texture.nrComponents = 1; break;
+        case GL_RG: texture.nrComponents = 2; break;
+        case GL_RGBA: texture.nrComponents = 4; break;
+        default: texture.nrComponents = 3; break;
+    }
+    texture.levels.clear();
+    unsigned int width = header.pixelWidth, height = header.pixelHeight;
+    for (uint32_t l = 0; l < header.numberOfMipmapLevels; l++)
+    {
+        uint32_t imageSize;
+        if (offset + sizeof(imageSize) > size)
+            return false;
+        memcpy(&imageSize, data + offset, sizeof(imageSize));
+        offset += sizeof(imageSize);
+        if (offset + imageSize > size)
+            return false;
+        texture.levels.push_back(TextureLevel{width, height, data + offset, imageSize});
+        offset = KtxPad4(offset + imageSize);
+        width = std::max(1u, width / 2);
+        height = std::max(1u, height / 2);
+    }
+    texture.storage.reset();
+    texture.file = file;
+    return true;
+}
+
+// maps a KTX file written by WriteKtx, see ParseKtx
+inline bool ReadKtx(const std::string &path, TextureLevels &texture)
+{
+    std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>(path);
+    return file->isOpen() && ParseKtx(file, file->data(), file->size(), texture);
+}
+
+inline std::string KtxValue(const TextureLevels &texture, const std::string &key)
+{
+    for (const auto &kv : texture.keyValues)
+        if (kv.first == key)
+            return kv.second;
+    return std::string();
+}
+
+// uploads levels firstLevel to lastLevel (both included) into textureID and makes firstLevel the finest level
+// sampled. The levels after lastLevel have to be uploaded already, so a texture can be filled from its smallest
+// level up. GL thread only.
+inline void UploadTextureLevels(unsigned int textureID, const TextureLevels &texture, size_t firstLevel, size_t lastLevel)
+{
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    for (size_t l = lastLevel + 1; l-- > firstLevel; )
+    {
+        const TextureLevel &level = texture.levels[l];
+        if (texture.compressed())
+            glCompressedTexImage2D(GL_TEXTURE_2D, l, texture.internalFormat, level.width, level.height, 0, level.size, level.data);
+        else
+            glTexImage2D(GL_TEXTURE_2D, l, texture.internalFormat, level.width, level.height, 0, texture.format, texture.type, level.data);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, firstLevel);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, texture.levels.size() - 1);
+    // single channel (BC4) specular maps are sampled as .rgb, replicate the channel. Set either way, a reloaded
+    // image may come in another format.
+    bool singleChannel = texture.internalFormat == GL_COMPRESSED_RED_RGTC1;
+    GLint swizzle[4] = {GL_RED, singleChannel ? GL_RED : GL_GREEN, singleChannel ? GL_RED : GL_BLUE, singleChannel ? GL_ONE : GL_ALPHA};
+    glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, swizzle);
+}
+
+// uploads every level into textureID, GL thread only
+inline void UploadTextureLevels(unsigned int textureID, const TextureLevels &texture)
+{
+    UploadTextureLevels(textureID, texture, 0, texture.levels.size() - 1);
+}
+#endif
@@ -0,0 +1,140 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstddef>
+#include <string>
+
+// directory (relative to the working directory, same as resources/) holding every generated cache file
+const char * const CACHE_DIRECTORY = "cache";
+
+// read-only memory mapping of a whole file. Move-only, the mapping is released in the destructor.
+class MappedFile
+{
+public:
+    MappedFile() : bytes(nullptr), length(0) {}
+
+    explicit MappedFile(const std::string &path) : bytes(nullptr), length(0)
+    {
+        open(path);
+    }
+
+    MappedFile(MappedFile &&other) noexcept : bytes(other.bytes), length(other.length)
+    {
+        other.bytes = nullptr;
+        other.length = 0;
+    }
+
+    MappedFile &operator=(MappedFile &&other) noexcept
+    {
+        if (this != &other)
+        {
+            close();
+            bytes = other.bytes;
+            length = other.length;
+            other.bytes = nullptr;
+            other.length = 0;
+        }
+        return *this;
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    ~MappedFile()
+    {
+        close();
+    }
+
+    // maps the file at path, returns false if it doesn't exist or can't be mapped
+    bool open(const std::string &path)
+    {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            void *mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping != MAP_FAILED)
+            {
+                bytes = static_cast<const unsigned char*>(mapping);
+                length = st.st_size;
+            }
+        }
+        // the mapping stays valid after the descriptor is closed
+        ::close(fd);
+        return bytes != nullptr;
+    }
+
+    void close()
+    {
+        if (bytes)
+            munmap(const_cast<unsigned char*>(bytes), length);
+        bytes = nullptr;
+        length = 0;
+    }
+
+    bool isOpen() const { return bytes != nullptr; }
+    const unsigned char *data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const unsigned char *bytes;
+    size_t length;
+};
+
+// creates every missing directory on the given path (mkdir -p)
+inline bool CreateDirectories(const std::string &path)
+{
+    for (size_t pos = path.find('/', 1); ; pos = path.find('/', pos + 1))
+    {
+        std::string prefix = path.substr(0, pos);
+        if (!prefix.empty() && mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST)
+            return false;
+        if (pos == std::string::npos)
+            return true;
+    }
+}
+
+// writes the file next to its destination and renames it into place, so a crash or a concurrent
+// reader never observes a half written cache file
+inline bool WriteFileAtomic(const std::string &path, const void *data, size_t size)
+{
+    size_t slash = path.find_last_of('/');
+    if (slash != std::string::npos && !CreateDirectories(path.substr(0, slash)))
+        return false;
+
+    std::string tmpPath = path + ".tmp" + std::to_string(getpid());
+    FILE *file = fopen(tmpPath.c_str(), "wb");
+    if (!file)
+        return false;
+    bool ok = fwrite(data, 1, size, file) == size;
+    ok = (fclose(file) == 0) && ok;
+    if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0)
+    {
+        remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+// maps a source asset path to a file inside the cache directory, e.g.
+// resources/objects/Armchair/Armchair.obj -> cache/resources_objects_Armchair_Armchair.obj.meshcache
+inline std::string CachePathFor(const std::string &sourcePath, const std::string &extension)
+{
+    std::string name = sourcePath;
+    for (char &c : name)
+    {
+        if (c == '/' || c == '\\' || c == ':')
+            c = '_';
+    }
+    return std::string(CACHE_DIRECTORY) + '/' + name + extension;
+}
+#endif
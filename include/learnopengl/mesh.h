@@ -6,8 +6,12 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include <learnopengl/hash.h>
 #include <learnopengl/shader.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <string>
 #include <vector>
 using namespace std;
@@ -33,73 +37,413 @@ struct Texture {
     string path;
 };
 
+// texture types (Texture::type) by their hash, worked out by the compiler: compare HashString(texture.type)
+// against these instead of the strings
+constexpr uint64_t TEXTURE_TYPE_DIFFUSE  = HashName("texture_diffuse");
+constexpr uint64_t TEXTURE_TYPE_SPECULAR = HashName("texture_specular");
+constexpr uint64_t TEXTURE_TYPE_NORMAL   = HashName("texture_normal");
+constexpr uint64_t TEXTURE_TYPE_HEIGHT   = HashName("texture_height");
+
+// a texture of a mesh as Mesh::Draw binds it: the texture unit, the sampler it is bound to and where the program
+// drawn with keeps that sampler
+struct TextureBinding {
+    GLint unit;
+    unsigned int texture;
+    UniformName sampler;
+    GLint location;     // -1 if the program has no such sampler
+};
+
+// layout of a mesh's vertex buffer. Unpacked it holds struct Vertex as is (56 bytes). Packed (see vertex_packing.h)
+// it holds, in this order:
+//   position   3 floats, or 4 normalized shorts relative to the mesh bounds (quantizedPositions)
+//   normal     GL_INT_2_10_10_10_REV
+//   tangent    GL_INT_2_10_10_10_REV, w is the sign of the bitangent: bitangent = cross(normal, tangent.xyz) * tangent.w
+//   texCoords  2 half floats (halfTexCoords) or 2 floats
+// which is 20 to 28 bytes. Shaders get the position as stored and apply positionScale/positionOffset themselves.
+struct VertexFormat {
+    bool packed = false;
+    bool quantizedPositions = false;
+    bool halfTexCoords = false;
+    // position = stored position * positionScale + positionOffset, identity unless quantizedPositions
+    glm::vec3 positionScale = glm::vec3(1.0f);
+    glm::vec3 positionOffset = glm::vec3(0.0f);
+
+    unsigned int positionSize() const { return quantizedPositions ? 4 * sizeof(short) : 3 * sizeof(float); }
+    unsigned int normalOffset() const { return positionSize(); }
+    unsigned int tangentOffset() const { return normalOffset() + sizeof(uint32_t); }
+    unsigned int texCoordsOffset() const { return tangentOffset() + sizeof(uint32_t); }
+    unsigned int stride() const
+    {
+        if (!packed)
+            return sizeof(Vertex);
+        return texCoordsOffset() + (halfTexCoords ? 2 * sizeof(uint16_t) : 2 * sizeof(float));
+    }
+};
+
+// vertices addressable by 16-bit indices
+const unsigned int SHORT_INDEX_VERTEX_LIMIT = 65536;
+
+inline unsigned int IndexSize(GLenum indexType)
+{
+    return indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(unsigned int);
+}
+
+// one level of detail of a mesh (see mesh_simplifier.h): a range of its index buffer, in indices, and the largest
+// distance in model units between this level and the full mesh. Level 0 is the full mesh.
+struct MeshLod {
+    uint32_t indexOffset;
+    uint32_t indexCount;
+    float    error;
+};
+
+// full mesh plus up to three simplified levels
+const unsigned int MESH_LOD_MAX_LEVELS = 4;
+// a level is drawn once its error projects to no more than this many pixels
+const float LOD_PIXEL_ERROR = 1.0f;
+
+// what LOD selection needs to know about the camera: its position and the pixels one model unit at distance 1
+// covers on screen, viewport height / (2 tan(fovy / 2))
+struct LodView {
+    glm::vec3 cameraPosition;
+    float pixelsPerUnit;
+
+    LodView(const glm::vec3 &cameraPosition, float fovyDegrees, float viewportHeight)
+        : cameraPosition(cameraPosition),
+          pixelsPerUnit(viewportHeight / (2.0f * std::tan(glm::radians(fovyDegrees) * 0.5f)))
+    {
+    }
+};
+
+// what a Model keeps in system memory once its meshes are uploaded:
+//   GEOMETRY_KEEP       full vertices and indices (of the full detail level) in Mesh::vertices and Mesh::indices
+//   GEOMETRY_POSITIONS  positions only in Mesh::positions plus Mesh::indices, enough for picking and culling
+//   GEOMETRY_DISCARD    nothing, the buffer objects hold the only copy
+enum Geometry_Residency {
+    GEOMETRY_KEEP,
+    GEOMETRY_POSITIONS,
+    GEOMETRY_DISCARD
+};
+
+// CPU side data of one mesh, produced by the import stage (on any thread) and uploaded later on the GL thread.
+// Either owns its arrays (fresh import) or points into a mapped mesh cache file, which then has to outlive the upload.
+// Owned vertices are in vertices until PackVertices moves them to packedVertices, owned indices in indices until
+// PackIndices moves them to shortIndices (if the vertex count allows it, indexType tells).
+// The index buffer holds every level of detail one after the other, lods tells where. No lods means one level.
+struct MeshData {
+    MeshData() = default;
+    // move only, the arrays are large and copies of them are never needed
+    MeshData(const MeshData &) = delete;
+    MeshData &operator=(const MeshData &) = delete;
+    MeshData(MeshData &&) = default;
+    MeshData &operator=(MeshData &&) = default;
+
+    vector<Vertex>        vertices;
+    vector<unsigned char> packedVertices;
+    vector<unsigned int>  indices;
+    vector<uint16_t>      shortIndices;
+    vector<Texture>       textures;  // type and path only, ids are assigned on upload
+    VertexFormat          format;
+    GLenum                indexType = GL_UNSIGNED_INT;
+    vector<MeshLod>       lods;
+    glm::vec3             boundsCenter = glm::vec3(0.0f);   // bounding sphere, a radius of 0 disables LOD selection
+    float                 boundsRadius = 0.0f;
+
+    const unsigned char *mappedVertices = nullptr;
+    const void          *mappedIndices = nullptr;
+    unsigned int         mappedVertexCount = 0;
+    unsigned int         mappedIndexCount = 0;
+
+    const void *vertexData() const
+    {
+        if (mappedVertices)
+            return mappedVertices;
+        return format.packed ? static_cast<const void*>(packedVertices.data()) : vertices.data();
+    }
+    unsigned int vertexCount() const
+    {
+        if (mappedVertices)
+            return mappedVertexCount;
+        return format.packed ? packedVertices.size() / format.stride() : vertices.size();
+    }
+    const void *indexData() const
+    {
+        if (mappedIndices)
+            return mappedIndices;
+        return indexType == GL_UNSIGNED_SHORT ? static_cast<const void*>(shortIndices.data()) : indices.data();
+    }
+    unsigned int indexCount() const
+    {
+        if (mappedIndices)
+            return mappedIndexCount;
+        return indexType == GL_UNSIGNED_SHORT ? shortIndices.size() : indices.size();
+    }
+};
+
 class Mesh {
 public:
     // mesh Data
     vector<Vertex>       vertices;
     vector<unsigned int> indices;
+    vector<glm::vec3>    positions;     // GEOMETRY_POSITIONS copy, in model space
     vector<Texture>      textures;
 
-    unsigned int VAO;
+    unsigned int VAO = 0;
+    unsigned int indexCount = 0;
+    GLenum indexType = GL_UNSIGNED_INT;
+    size_t bufferBytes = 0;     // size of the vertex and index buffers
+    VertexFormat format;
+    vector<MeshLod> lods;       // empty: the whole index buffer is the only level
+    glm::vec3 boundsCenter = glm::vec3(0.0f);
+    float boundsRadius = 0.0f;
     std::string glslIdentifierPrefix;
-    // constructor
+    // constructor, takes over the arrays: pass them with std::move unless the caller still needs them
     Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures)
     {
-        this->vertices = vertices;
-        this->indices = indices;
-        this->textures = textures;
+        this->vertices = std::move(vertices);
+        this->indices = std::move(indices);
+        this->textures = std::move(textures);
 
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
-        setupMesh();
+        // 16-bit indices whenever all vertices can be addressed with them, the CPU copy stays 32-bit
+        if (this->vertices.size() <= SHORT_INDEX_VERTEX_LIMIT)
+        {
+            vector<uint16_t> shortIndices(this->indices.begin(), this->indices.end());
+            setupMesh(this->vertices.data(), this->vertices.size(), shortIndices.data(), GL_UNSIGNED_SHORT, shortIndices.size());
+        }
+        else
+            setupMesh(this->vertices.data(), this->vertices.size(), this->indices.data(), GL_UNSIGNED_INT, this->indices.size());
+        setupTextureBindings();
     }
 
-    // render the mesh
-    void Draw(Shader &shader)
+    // constructor used by the model loader: uploads vertices in any format from memory owned by someone else
+    // (a mapped cache file or the import result) without keeping a CPU side copy, vertices and indices stay empty.
+    // indexType is GL_UNSIGNED_SHORT or GL_UNSIGNED_INT.
+    Mesh(const void *vertexData, unsigned int vertexCount, const VertexFormat &format, const void *indexData,
+         GLenum indexType, unsigned int indexCount, vector<Texture> textures)
     {
-        // bind appropriate textures
-        unsigned int diffuseNr  = 1;
-        unsigned int specularNr = 1;
-        unsigned int normalNr   = 1;
-        unsigned int heightNr   = 1;
-        for(unsigned int i = 0; i < textures.size(); i++)
-        {
-            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
-            // retrieve texture number (the N in diffuse_textureN)
-            string number;
-            string name = textures[i].type;
-            if(name == "texture_diffuse")
-                number = std::to_string(diffuseNr++);
-            else if(name == "texture_specular")
-                number = std::to_string(specularNr++); // transfer unsigned int to stream
-            else if(name == "texture_normal")
-                number = std::to_string(normalNr++); // transfer unsigned int to stream
-            else if(name == "texture_height")
-                number = std::to_string(heightNr++); // transfer unsigned int to stream
+        this->textures = std::move(textures);
+        this->format = format;
+        setupMesh(vertexData, vertexCount, indexData, indexType, indexCount);
+        setupTextureBindings();
+    }
 
-            // now set the sampler to the correct texture unit
-            glUniform1i(glGetUniformLocation(shader.ID, (glslIdentifierPrefix + name + number).c_str()), i);
-            // and finally bind the texture
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
+    // a mesh owns its buffer objects, so it can be moved (into Model::meshes) but not copied
+    Mesh(const Mesh &) = delete;
+    Mesh &operator=(const Mesh &) = delete;
+
+    Mesh(Mesh &&other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    Mesh &operator=(Mesh &&other) noexcept
+    {
+        if (this == &other)
+            return *this;
+        release();
+        vertices = std::move(other.vertices);
+        indices = std::move(other.indices);
+        positions = std::move(other.positions);
+        textures = std::move(other.textures);
+        VAO = other.VAO;
+        VBO = other.VBO;
+        EBO = other.EBO;
+        other.VAO = other.VBO = other.EBO = 0;
+        indexCount = other.indexCount;
+        indexType = other.indexType;
+        bufferBytes = other.bufferBytes;
+        format = other.format;
+        lods = std::move(other.lods);
+        boundsCenter = other.boundsCenter;
+        boundsRadius = other.boundsRadius;
+        glslIdentifierPrefix = std::move(other.glslIdentifierPrefix);
+        textureBindings = std::move(other.textureBindings);
+        positionScaleLocation = other.positionScaleLocation;
+        positionOffsetLocation = other.positionOffsetLocation;
+        uniformGeneration = other.uniformGeneration;
+        return *this;
+    }
+
+    ~Mesh()
+    {
+        release();
+    }
+
+    // system memory held by the CPU side copies, see Geometry_Residency
+    size_t cpuBytes() const
+    {
+        return vertices.capacity() * sizeof(Vertex) + indices.capacity() * sizeof(unsigned int)
+             + positions.capacity() * sizeof(glm::vec3);
+    }
+
+    // drops the CPU side copies down to what residency keeps. Meshes built from vertices and indices start out
+    // as GEOMETRY_KEEP, the model loader fills in the copies itself.
+    void setResidency(Geometry_Residency residency)
+    {
+        if (residency == GEOMETRY_POSITIONS && positions.empty())
+        {
+            positions.reserve(vertices.size());
+            for (const Vertex &vertex : vertices)
+                positions.push_back(vertex.Position);
+        }
+        if (residency != GEOMETRY_KEEP)
+            vector<Vertex>().swap(vertices);
+        if (residency == GEOMETRY_DISCARD)
+        {
+            vector<unsigned int>().swap(indices);
+            vector<glm::vec3>().swap(positions);
         }
+    }
+
+    // the coarsest level whose error stays below LOD_PIXEL_ERROR on screen when drawn with the given model matrix.
+    // The error of a level scales with the projected radius of the bounding sphere, taken at its nearest point.
+    unsigned int SelectLod(const glm::mat4 &model, const LodView &view) const
+    {
+        if (lods.size() < 2 || boundsRadius <= 0.0f)
+            return 0;
+        glm::vec3 center = glm::vec3(model * glm::vec4(boundsCenter, 1.0f));
+        float scale = std::sqrt(std::max(glm::dot(model[0], model[0]), std::max(glm::dot(model[1], model[1]), glm::dot(model[2], model[2]))));
+        float radius = boundsRadius * scale;
+        float distance = glm::length(center - view.cameraPosition) - radius;
+        if (distance <= 0.0f)
+            return 0;   // inside the bounding sphere
+
+        float projectedRadius = radius / distance * view.pixelsPerUnit;
+        unsigned int lod = 0;
+        for (unsigned int i = 1; i < lods.size(); i++)
+            if (lods[i].error / boundsRadius * projectedRadius <= LOD_PIXEL_ERROR)
+                lod = i;
+        return lod;
+    }
 
+    // prefix of the sampler uniforms the textures are bound to, "material." for material.texture_diffuse1
+    void SetTextureNamePrefix(const std::string &prefix)
+    {
+        glslIdentifierPrefix = prefix;
+        setupTextureBindings();
+    }
 
+    // render the mesh, lod picks the level of detail (see SelectLod)
+    void Draw(Shader &shader, unsigned int lod = 0)
+    {
+        Bind(shader);
 
         // draw mesh
         glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+        DrawElements(lod);
         glBindVertexArray(0);
 
         // always good practice to set everything back to defaults once configured.
         glActiveTexture(GL_TEXTURE0);
     }
 
+    // first half of Draw for callers that track state themselves (see RenderQueue): binds the textures and sets
+    // the mesh's uniforms of the program in use
+    void Bind(Shader &shader)
+    {
+        // the locations are looked up once per program, and again after it was reloaded
+        if (shader.uniformTable().getGeneration() != uniformGeneration)
+            resolveLocations(shader.uniformTable());
+
+        // bind appropriate textures
+        for (const TextureBinding &binding : textureBindings)
+        {
+            glActiveTexture(GL_TEXTURE0 + binding.unit); // active proper texture unit before binding
+            // now set the sampler to the correct texture unit
+            SetUniform(binding.location, binding.unit);
+            // and finally bind the texture
+            glBindTexture(GL_TEXTURE_2D, binding.texture);
+        }
+
+        // undo the position quantization of packed vertices, identity for everything else
+        SetUniform(positionScaleLocation, format.positionScale);
+        SetUniform(positionOffsetLocation, format.positionOffset);
+    }
+
+    // second half of Draw: the triangles of a level, with VAO bound
+    void DrawElements(unsigned int lod = 0) const
+    {
+        if (lods.empty())
+            glDrawElements(GL_TRIANGLES, indexCount, indexType, 0);
+        else
+        {
+            const MeshLod &level = lods[std::min<size_t>(lod, lods.size() - 1)];
+            glDrawElements(GL_TRIANGLES, level.indexCount, indexType, (void*)(uintptr_t)(level.indexOffset * IndexSize(indexType)));
+        }
+    }
+
 private:
     // render data
-    unsigned int VBO, EBO;
+    unsigned int VBO = 0, EBO = 0;
+    // what Draw binds, worked out when the textures are set instead of every draw
+    vector<TextureBinding> textureBindings;
+    GLint positionScaleLocation = -1;
+    GLint positionOffsetLocation = -1;
+    uint64_t uniformGeneration = 0;     // UniformTable::getGeneration the locations were resolved with
+
+    void release()
+    {
+        if (VAO == 0)
+            return;
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+        VAO = VBO = EBO = 0;
+    }
+
+    // texture i goes to unit i, the N-th texture of a type to the sampler (prefix)(type)N, e.g. texture_diffuse1.
+    // The locations are resolved by the next draw.
+    void setupTextureBindings()
+    {
+        unsigned int diffuseNr  = 1;
+        unsigned int specularNr = 1;
+        unsigned int normalNr   = 1;
+        unsigned int heightNr   = 1;
+        textureBindings.clear();
+        textureBindings.reserve(textures.size());
+        for(unsigned int i = 0; i < textures.size(); i++)
+        {
+            // retrieve texture number (the N in diffuse_textureN)
+            string number;
+            switch (HashString(textures[i].type))
+            {
+            case TEXTURE_TYPE_DIFFUSE:
+                number = std::to_string(diffuseNr++);
+                break;
+            case TEXTURE_TYPE_SPECULAR:
+                number = std::to_string(specularNr++);
+                break;
+            case TEXTURE_TYPE_NORMAL:
+                number = std::to_string(normalNr++);
+                break;
+            case TEXTURE_TYPE_HEIGHT:
+                number = std::to_string(heightNr++);
+                break;
+            }
+            textureBindings.push_back(TextureBinding{GLint(i), textures[i].id,
+                                                     UniformName(glslIdentifierPrefix + textures[i].type + number), -1});
+        }
+        uniformGeneration = 0;
+    }
+
+    void resolveLocations(const UniformTable &uniforms)
+    {
+        constexpr UniformName positionScale("positionScale");
+        constexpr UniformName positionOffset("positionOffset");
+        for (TextureBinding &binding : textureBindings)
+            binding.location = uniforms.location(binding.sampler);
+        positionScaleLocation = uniforms.location(positionScale);
+        positionOffsetLocation = uniforms.location(positionOffset);
+        uniformGeneration = uniforms.getGeneration();
+    }
 
     // initializes all the buffer objects/arrays
-    void setupMesh()
+    void setupMesh(const void *vertexData, unsigned int vertexCount, const void *indexData, GLenum indexType, unsigned int indexCount)
     {
+        this->indexCount = indexCount;
+        this->indexType = indexType;
+        this->bufferBytes = size_t(vertexCount) * format.stride() + size_t(indexCount) * IndexSize(indexType);
+
         // create buffers/arrays
         glGenVertexArrays(1, &VAO);
         glGenBuffers(1, &VBO);
@@ -111,12 +455,22 @@ private:
         // A great thing about structs is that their memory layout is sequential for all its items.
         // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
         // again translates to 3/2 floats which translates to a byte array.
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+        glBufferData(GL_ARRAY_BUFFER, vertexCount * format.stride(), vertexData, GL_STATIC_DRAW);
 
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * IndexSize(indexType), indexData, GL_STATIC_DRAW);
+
+        if (format.packed)
+            setupPackedAttributes();
+        else
+            setupAttributes();
 
-        // set the vertex attribute pointers
+        glBindVertexArray(0);
+    }
+
+    // set the vertex attribute pointers
+    void setupAttributes()
+    {
         // vertex Positions
         glEnableVertexAttribArray(0);
         glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
@@ -132,8 +486,28 @@ private:
         // vertex bitangent
         glEnableVertexAttribArray(4);
         glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
+    }
 
-        glBindVertexArray(0);
+    // same attribute locations for the packed layout, see VertexFormat. There is no bitangent attribute,
+    // the tangent is a vec4 carrying its sign.
+    void setupPackedAttributes()
+    {
+        GLsizei stride = format.stride();
+        // vertex Positions
+        glEnableVertexAttribArray(0);
+        if (format.quantizedPositions)
+            glVertexAttribPointer(0, 3, GL_SHORT, GL_TRUE, stride, (void*)0);
+        else
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+        // vertex normals
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void*)(uintptr_t)format.normalOffset());
+        // vertex texture coords
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, format.halfTexCoords ? GL_HALF_FLOAT : GL_FLOAT, GL_FALSE, stride, (void*)(uintptr_t)format.texCoordsOffset());
+        // vertex tangent
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void*)(uintptr_t)format.tangentOffset());
     }
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,307 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <learnopengl/hash.h>
+#include <learnopengl/mapped_file.h>
+#include <learnopengl/mesh.h>
+#include <learnopengl/scene_pack.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Binary cache of the post-processed meshes of a model. Once written, a warm start maps the cache file and uploads
+// vertices and indices straight from the mapping, without going through Assimp at all.
+//
+// layout: MeshCacheHeader | MeshCacheEntry[meshCount] | per mesh: vertices (in the mesh's VertexFormat), indices
+// (all levels of detail), MeshLod[lodCount], texture records
+// every block starts on a MESH_CACHE_ALIGNMENT boundary so the mapped arrays can be used in place.
+// Bump MESH_CACHE_VERSION whenever the layout or the import pipeline changes, old files are then rebuilt.
+const uint32_t MESH_CACHE_VERSION   = 7;
+const uint32_t MESH_CACHE_ALIGNMENT = 16;
+const char MESH_CACHE_MAGIC[8] = {'M', 'E', 'S', 'H', 'C', 'C', 'H', '\0'};
+
+struct MeshCacheHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t vertexSize;
+    uint64_t key;
+    uint32_t meshCount;
+    uint32_t reserved;
+    uint64_t sourceSize;        // stamp of the model file when it was imported (see StampFile), 0 in a scene pack
+    int64_t  sourceModified;
+};
+
+// VertexFormat and index type flags of a cached mesh
+const uint32_t MESH_CACHE_PACKED              = 1;
+const uint32_t MESH_CACHE_QUANTIZED_POSITIONS = 2;
+const uint32_t MESH_CACHE_HALF_TEXCOORDS      = 4;
+const uint32_t MESH_CACHE_SHORT_INDICES       = 8;
+
+struct MeshCacheEntry {
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+    uint64_t textureOffset;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t textureCount;
+    uint32_t flags;
+    float    positionScale[3];
+    float    positionOffset[3];
+    float    boundsCenter[3];
+    float    boundsRadius;
+    uint64_t lodOffset;
+    uint32_t lodCount;
+    uint32_t reserved;
+};
+
+class MeshCache
+{
+public:
+    // key of a model: content of the source file and of the files it pulls in (material libraries), combined with
+    // the import flags and the cache version. A dependency that can't be read counts by its name only.
+    static uint64_t KeyFor(const MappedFile &source, unsigned int importFlags,
+                           const vector<string> &dependencies = vector<string>())
+    {
+        uint64_t key = HashContent(source.data(), source.size());
+        for (const string &dependency : dependencies)
+        {
+            key = HashString(dependency, key);
+            MappedFile file(dependency);
+            if (file.isOpen())
+                key = HashValue(HashContent(file.data(), file.size()), key);
+        }
+        key = HashValue(importFlags, key);
+        return HashValue(MESH_CACHE_VERSION, key);
+    }
+
+    // maps the cache file and validates it against the expected key, returns false if it is missing or stale
+    bool load(const string &cachePath, uint64_t key)
+    {
+        invalidate();
+        if (!file.open(cachePath))
+            return false;
+        return parse(file.data(), file.size(), &key);
+    }
+
+    // uses a cache that lies at base inside a mapping owned by someone else (a mounted ScenePack), keeping owner
+    // alive. The key isn't checked, the pack was cooked from the sources; version and layout still are.
+    bool load(const std::shared_ptr<MappedFile> &owner, const unsigned char *base, size_t size)
+    {
+        invalidate();
+        sharedFile = owner;
+        return parse(base, size, nullptr);
+    }
+
+    vector<MeshData> &getMeshes()
+    {
+        return meshes;
+    }
+
+    // bounding sphere of the whole model from the entries of the cache at base, nothing but the directory is read.
+    // Instead of the key, which takes hashing the sources, the stamp of the model file is checked if one is given:
+    // the geometry only comes from that file. Returns false if the cache is stale, unusable or has no meshes.
+    static bool ReadBounds(const unsigned char *base, size_t size, const SourceStamp *source, glm::vec3 &center, float &radius)
+    {
+        if (size < sizeof(MeshCacheHeader))
+            return false;
+        MeshCacheHeader header;
+        memcpy(&header, base, sizeof(header));
+        if (memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic)) != 0 || header.version != MESH_CACHE_VERSION
+            || header.vertexSize != sizeof(Vertex) || header.meshCount == 0
+            || (source && (header.sourceSize != source->size || header.sourceModified != source->modified))
+            || size < sizeof(MeshCacheHeader) + header.meshCount * sizeof(MeshCacheEntry))
+            return false;
+
+        // the spheres of the meshes, merged around their box
+        vector<MeshCacheEntry> entries(header.meshCount);
+        memcpy(entries.data(), base + sizeof(MeshCacheHeader), entries.size() * sizeof(MeshCacheEntry));
+        glm::vec3 low(std::numeric_limits<float>::max()), high(-std::numeric_limits<float>::max());
+        for (const MeshCacheEntry &entry : entries)
+        {
+            glm::vec3 meshCenter(entry.boundsCenter[0], entry.boundsCenter[1], entry.boundsCenter[2]);
+            low = glm::min(low, meshCenter - glm::vec3(entry.boundsRadius));
+            high = glm::max(high, meshCenter + glm::vec3(entry.boundsRadius));
+        }
+        center = (low + high) * 0.5f;
+        radius = 0.0f;
+        for (const MeshCacheEntry &entry : entries)
+        {
+            glm::vec3 meshCenter(entry.boundsCenter[0], entry.boundsCenter[1], entry.boundsCenter[2]);
+            radius = std::max(radius, glm::length(meshCenter - center) + entry.boundsRadius);
+        }
+        return true;
+    }
+
+    // serializes the meshes of a freshly imported model, read from the file stamped source, failure only means the
+    // next start imports again
+    static bool Store(const string &cachePath, uint64_t key, const vector<MeshData> &meshes, const SourceStamp &source)
+    {
+        string blob = Serialize(key, meshes, &source);
+        return WriteFileAtomic(cachePath, blob.data(), blob.size());
+    }
+
+    // the meshes as the bytes of a cache file
+    static string Serialize(uint64_t key, const vector<MeshData> &meshes, const SourceStamp *source = nullptr)
+    {
+        MeshCacheHeader header;
+        memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic));
+        header.version    = MESH_CACHE_VERSION;
+        header.vertexSize = sizeof(Vertex);
+        header.key        = key;
+        header.meshCount  = meshes.size();
+        header.reserved   = 0;
+        header.sourceSize     = source ? source->size : 0;
+        header.sourceModified = source ? source->modified : 0;
+
+        vector<MeshCacheEntry> entries(meshes.size());
+        string blob(sizeof(MeshCacheHeader) + entries.size() * sizeof(MeshCacheEntry), '\0');
+        for (size_t i = 0; i < meshes.size(); i++)
+        {
+            const MeshData &mesh = meshes[i];
+            MeshCacheEntry &entry = entries[i];
+            entry.vertexCount  = mesh.vertexCount();
+            entry.indexCount   = mesh.indexCount();
+            entry.textureCount = mesh.textures.size();
+            entry.flags = (mesh.format.packed ? MESH_CACHE_PACKED : 0)
+                        | (mesh.format.quantizedPositions ? MESH_CACHE_QUANTIZED_POSITIONS : 0)
+                        | (mesh.format.halfTexCoords ? MESH_CACHE_HALF_TEXCOORDS : 0)
+                        | (mesh.indexType == GL_UNSIGNED_SHORT ? MESH_CACHE_SHORT_INDICES : 0);
+            for (int c = 0; c < 3; c++)
+            {
+                entry.positionScale[c] = mesh.format.positionScale[c];
+                entry.positionOffset[c] = mesh.format.positionOffset[c];
+                entry.boundsCenter[c] = mesh.boundsCenter[c];
+            }
+            entry.boundsRadius = mesh.boundsRadius;
+            entry.lodCount = mesh.lods.size();
+            entry.reserved = 0;
+
+            entry.vertexOffset = append(blob, mesh.vertexData(), mesh.vertexCount() * mesh.format.stride());
+            entry.indexOffset  = append(blob, mesh.indexData(), mesh.indexCount() * IndexSize(mesh.indexType));
+            entry.lodOffset    = append(blob, mesh.lods.data(), mesh.lods.size() * sizeof(MeshLod));
+            entry.textureOffset = align(blob);
+            for (const Texture &texture : mesh.textures)
+            {
+                appendString(blob, texture.type);
+                appendString(blob, texture.path);
+            }
+        }
+        memcpy(&blob[0], &header, sizeof(header));
+        if (!entries.empty())
+            memcpy(&blob[sizeof(header)], entries.data(), entries.size() * sizeof(MeshCacheEntry));
+
+        return blob;
+    }
+
+private:
+    MappedFile file;
+    std::shared_ptr<MappedFile> sharedFile;
+    vector<MeshData> meshes;
+
+    bool invalidate()
+    {
+        meshes.clear();
+        file.close();
+        sharedFile.reset();
+        return false;
+    }
+
+    // reads the cache at base, checking the key if one is given
+    bool parse(const unsigned char *base, size_t size, const uint64_t *key)
+    {
+        if (size < sizeof(MeshCacheHeader))
+            return invalidate();
+
+        MeshCacheHeader header;
+        memcpy(&header, base, sizeof(header));
+        if (memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(header.magic)) != 0 || header.version != MESH_CACHE_VERSION
+            || header.vertexSize != sizeof(Vertex) || (key && header.key != *key))
+            return invalidate();
+        if (size < sizeof(MeshCacheHeader) + header.meshCount * sizeof(MeshCacheEntry))
+            return invalidate();
+
+        const MeshCacheEntry *entries = reinterpret_cast<const MeshCacheEntry*>(base + sizeof(MeshCacheHeader));
+        for (uint32_t i = 0; i < header.meshCount; i++)
+        {
+            const MeshCacheEntry &entry = entries[i];
+            MeshData mesh;
+            mesh.format.packed = (entry.flags & MESH_CACHE_PACKED) != 0;
+            mesh.format.quantizedPositions = (entry.flags & MESH_CACHE_QUANTIZED_POSITIONS) != 0;
+            mesh.format.halfTexCoords = (entry.flags & MESH_CACHE_HALF_TEXCOORDS) != 0;
+            mesh.indexType = (entry.flags & MESH_CACHE_SHORT_INDICES) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+            mesh.format.positionScale = glm::vec3(entry.positionScale[0], entry.positionScale[1], entry.positionScale[2]);
+            mesh.format.positionOffset = glm::vec3(entry.positionOffset[0], entry.positionOffset[1], entry.positionOffset[2]);
+            if (entry.vertexOffset + uint64_t(entry.vertexCount) * mesh.format.stride() > size
+                || entry.indexOffset + uint64_t(entry.indexCount) * IndexSize(mesh.indexType) > size
+                || entry.lodOffset + uint64_t(entry.lodCount) * sizeof(MeshLod) > size
+                || entry.textureOffset > size)
+                return invalidate();
+            mesh.boundsCenter = glm::vec3(entry.boundsCenter[0], entry.boundsCenter[1], entry.boundsCenter[2]);
+            mesh.boundsRadius = entry.boundsRadius;
+            mesh.lods.resize(entry.lodCount);
+            if (entry.lodCount > 0)
+                memcpy(mesh.lods.data(), base + entry.lodOffset, entry.lodCount * sizeof(MeshLod));
+            for (const MeshLod &lod : mesh.lods)
+                if (uint64_t(lod.indexOffset) + lod.indexCount > entry.indexCount)
+                    return invalidate();
+
+            // the arrays are used in place, the returned meshes are only valid while this cache is alive
+            mesh.mappedVertices    = base + entry.vertexOffset;
+            mesh.mappedVertexCount = entry.vertexCount;
+            mesh.mappedIndices     = base + entry.indexOffset;
+            mesh.mappedIndexCount  = entry.indexCount;
+
+            size_t offset = entry.textureOffset;
+            for (uint32_t t = 0; t < entry.textureCount; t++)
+            {
+                Texture texture;
+                texture.id = 0;
+                if (!readString(base, size, offset, texture.type) || !readString(base, size, offset, texture.path))
+                    return invalidate();
+                mesh.textures.push_back(texture);
+            }
+            meshes.push_back(std::move(mesh));
+        }
+        return true;
+    }
+
+    static bool readString(const unsigned char *base, size_t size, size_t &offset, string &out)
+    {
+        uint32_t length;
+        if (offset + sizeof(length) > size)
+            return false;
+        memcpy(&length, base + offset, sizeof(length));
+        offset += sizeof(length);
+        if (offset + length > size)
+            return false;
+        out.assign(reinterpret_cast<const char*>(base + offset), length);
+        offset += length;
+        return true;
+    }
+
+    static uint64_t align(string &blob)
+    {
+        blob.resize((blob.size() + MESH_CACHE_ALIGNMENT - 1) / MESH_CACHE_ALIGNMENT * MESH_CACHE_ALIGNMENT, '\0');
+        return blob.size();
+    }
+
+    static uint64_t append(string &blob, const void *data, size_t size)
+    {
+        uint64_t offset = align(blob);
+        blob.append(static_cast<const char*>(data), size);
+        return offset;
+    }
+
+    static void appendString(string &blob, const string &str)
+    {
+        uint32_t length = str.size();
+        blob.append(reinterpret_cast<const char*>(&length), sizeof(length));
+        blob.append(str);
+    }
+};
+#endif
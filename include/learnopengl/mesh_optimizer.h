@@ -0,0 +1,321 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <learnopengl/mesh.h>
+
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Import-time optimization of indexed triangle meshes, run once per model before it goes into the mesh cache:
+//   1. WeldVertices merges duplicates (the importer emits one vertex per face corner) through a spatial hash,
+//   2. OptimizeVertexCache reorders triangles for the post-transform vertex cache (Tipsify, Sander et al. 2007),
+//   3. OptimizeVertexFetch renumbers vertices in first use order, so the vertex buffer is read front to back.
+// ComputeACMR measures the result: average cache misses per triangle, i.e. vertex shader runs per triangle.
+// SplitMesh then cuts meshes too large for 16-bit indices into parts that fit.
+
+// vertices closer than this (in model units) with matching attributes become one
+const float WELD_POSITION_EPSILON  = 1e-5f;
+const float WELD_ATTRIBUTE_EPSILON = 1e-4f;
+// grid cell size of the weld hash, large compared to the epsilon so most lookups touch a single cell
+const float WELD_CELL_SIZE = 1e-2f;
+// post-transform cache size assumed for optimizing and measuring, a FIFO of 16 is a conservative model
+const unsigned int VERTEX_CACHE_SIZE = 16;
+// meshes that would need more parts than this keep 32-bit indices: every part costs a draw call, while the
+// memory saved per part stays the same
+const unsigned int MESH_SPLIT_MAX_PARTS = 8;
+
+inline bool NearlyEqual(const glm::vec3 &a, const glm::vec3 &b, float epsilon)
+{
+    return std::fabs(a.x - b.x) <= epsilon && std::fabs(a.y - b.y) <= epsilon && std::fabs(a.z - b.z) <= epsilon;
+}
+
+inline bool CanWeld(const Vertex &a, const Vertex &b)
+{
+    return NearlyEqual(a.Position, b.Position, WELD_POSITION_EPSILON)
+        && NearlyEqual(a.Normal, b.Normal, WELD_ATTRIBUTE_EPSILON)
+        && std::fabs(a.TexCoords.x - b.TexCoords.x) <= WELD_ATTRIBUTE_EPSILON
+        && std::fabs(a.TexCoords.y - b.TexCoords.y) <= WELD_ATTRIBUTE_EPSILON
+        && NearlyEqual(a.Tangent, b.Tangent, WELD_ATTRIBUTE_EPSILON)
+        && NearlyEqual(a.Bitangent, b.Bitangent, WELD_ATTRIBUTE_EPSILON);
+}
+
+// merges vertices that CanWeld, rewrites the indices and drops triangles that became degenerate
+inline void WeldVertices(vector<Vertex> &vertices, vector<unsigned int> &indices)
+{
+    auto cellKey = [](int64_t x, int64_t y, int64_t z) {
+        return uint64_t(x) * 73856093ULL ^ uint64_t(y) * 19349663ULL ^ uint64_t(z) * 83492791ULL;
+    };
+
+    vector<Vertex> welded;
+    welded.reserve(vertices.size());
+    vector<unsigned int> remap(vertices.size());
+    // per cell a linked list (through next) of the welded vertices in it. Distinct cells sharing a key only cost
+    // a few extra comparisons.
+    std::unordered_map<uint64_t, unsigned int> cellHead;
+    cellHead.reserve(vertices.size());
+    vector<unsigned int> next;
+    next.reserve(vertices.size());
+    const unsigned int none = ~0u;
+    const float margin = WELD_POSITION_EPSILON / WELD_CELL_SIZE;
+
+    for (unsigned int v = 0; v < vertices.size(); v++)
+    {
+        const Vertex &vertex = vertices[v];
+        int64_t cell[3], low[3], high[3];
+        for (int a = 0; a < 3; a++)
+        {
+            float scaled = vertex.Position[a] / WELD_CELL_SIZE;
+            float floored = std::floor(scaled);
+            cell[a] = int64_t(floored);
+            // a neighbouring cell only has to be searched if the vertex lies within the epsilon of its border
+            low[a] = scaled - floored < margin ? cell[a] - 1 : cell[a];
+            high[a] = scaled - floored > 1.0f - margin ? cell[a] + 1 : cell[a];
+        }
+
+        unsigned int match = none;
+        for (int64_t x = low[0]; x <= high[0] && match == none; x++)
+            for (int64_t y = low[1]; y <= high[1] && match == none; y++)
+                for (int64_t z = low[2]; z <= high[2] && match == none; z++)
+                {
+                    auto head = cellHead.find(cellKey(x, y, z));
+                    for (unsigned int u = head == cellHead.end() ? none : head->second; u != none; u = next[u])
+                        if (CanWeld(welded[u], vertex))
+                        {
+                            match = u;
+                            break;
+                        }
+                }
+
+        if (match == none)
+        {
+            match = welded.size();
+            welded.push_back(vertex);
+            auto head = cellHead.emplace(cellKey(cell[0], cell[1], cell[2]), none).first;
+            next.push_back(head->second);
+            head->second = match;
+        }
+        remap[v] = match;
+    }
+
+    vector<unsigned int> remapped;
+    remapped.reserve(indices.size());
+    for (size_t t = 0; t + 2 < indices.size(); t += 3)
+    {
+        unsigned int a = remap[indices[t]], b = remap[indices[t + 1]], c = remap[indices[t + 2]];
+        if (a == b || b == c || a == c)
+            continue;
+        remapped.push_back(a);
+        remapped.push_back(b);
+        remapped.push_back(c);
+    }
+    vertices.swap(welded);
+    indices.swap(remapped);
+}
+
+// average number of FIFO cache misses per triangle, between 0.5 (ideal for large regular meshes) and 3
+inline float ComputeACMR(const vector<unsigned int> &indices, unsigned int vertexCount, unsigned int cacheSize = VERTEX_CACHE_SIZE)
+{
+    if (indices.size() < 3)
+        return 0.0f;
+    // cached[v]: time v entered the cache, it is still in there while fewer than cacheSize misses happened since
+    vector<int64_t> cached(vertexCount, -int64_t(cacheSize) - 1);
+    int64_t misses = 0;
+    for (unsigned int v : indices)
+    {
+        if (misses - cached[v] > int64_t(cacheSize))
+        {
+            cached[v] = misses;
+            misses++;
+        }
+    }
+    return float(misses) / float(indices.size() / 3);
+}
+
+// Tipsify: walks the mesh fanning around one vertex at a time, picking as the next fan center a vertex of the
+// current fan that will still be in the cache after its remaining triangles are emitted. Linear time.
+inline void OptimizeVertexCache(vector<unsigned int> &indices, unsigned int vertexCount, unsigned int cacheSize = VERTEX_CACHE_SIZE)
+{
+    size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0)
+        return;
+
+    // vertex -> triangles adjacency, as offsets into one array
+    vector<unsigned int> liveTriangles(vertexCount, 0);
+    for (unsigned int v : indices)
+        liveTriangles[v]++;
+    vector<unsigned int> adjacencyOffset(vertexCount + 1, 0);
+    for (unsigned int v = 0; v < vertexCount; v++)
+        adjacencyOffset[v + 1] = adjacencyOffset[v] + liveTriangles[v];
+    vector<unsigned int> adjacency(indices.size());
+    {
+        vector<unsigned int> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+        for (size_t i = 0; i < indices.size(); i++)
+            adjacency[fill[indices[i]]++] = i / 3;
+    }
+
+    vector<int64_t> cacheTime(vertexCount, 0);
+    vector<bool> emitted(triangleCount, false);
+    vector<unsigned int> deadEnds;
+    vector<unsigned int> output;
+    output.reserve(indices.size());
+    int64_t time = cacheSize + 1;
+    unsigned int cursor = 0;
+    vector<unsigned int> candidates;
+
+    // fan center to continue with once the current fan is exhausted: a recently touched vertex that still has
+    // triangles, else the next vertex in input order that has any
+    auto skipDeadEnd = [&]() -> int64_t {
+        while (!deadEnds.empty())
+        {
+            unsigned int v = deadEnds.back();
+            deadEnds.pop_back();
+            if (liveTriangles[v] > 0)
+                return v;
+        }
+        for (; cursor < vertexCount; cursor++)
+            if (liveTriangles[cursor] > 0)
+                return cursor;
+        return -1;
+    };
+
+    int64_t fan = skipDeadEnd();
+    while (fan >= 0)
+    {
+        candidates.clear();
+        for (unsigned int a = adjacencyOffset[fan]; a < adjacencyOffset[fan + 1]; a++)
+        {
+            unsigned int t = adjacency[a];
+            if (emitted[t])
+                continue;
+            emitted[t] = true;
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned int v = indices[3 * t + k];
+                output.push_back(v);
+                deadEnds.push_back(v);
+                candidates.push_back(v);
+                liveTriangles[v]--;
+                if (time - cacheTime[v] > int64_t(cacheSize))
+                    cacheTime[v] = time++;
+            }
+        }
+
+        // prefer the candidate that entered the cache earliest among those that stay cached through their fan
+        int64_t best = -1, bestPriority = -1;
+        for (unsigned int v : candidates)
+        {
+            if (liveTriangles[v] == 0)
+                continue;
+            int64_t priority = 0;
+            if (time - cacheTime[v] + 2 * int64_t(liveTriangles[v]) <= int64_t(cacheSize))
+                priority = time - cacheTime[v];
+            if (priority > bestPriority)
+            {
+                bestPriority = priority;
+                best = v;
+            }
+        }
+        fan = best >= 0 ? best : skipDeadEnd();
+    }
+    indices.swap(output);
+}
+
+// renumbers vertices in the order the index buffer first references them and drops unreferenced ones
+inline void OptimizeVertexFetch(vector<Vertex> &vertices, vector<unsigned int> &indices)
+{
+    const unsigned int none = ~0u;
+    vector<unsigned int> remap(vertices.size(), none);
+    vector<Vertex> ordered;
+    ordered.reserve(vertices.size());
+    for (unsigned int &index : indices)
+    {
+        if (remap[index] == none)
+        {
+            remap[index] = ordered.size();
+            ordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices.swap(ordered);
+}
+
+// moves mesh to out, split into parts of at most SHORT_INDEX_VERTEX_LIMIT vertices if it has more and needs no more
+// than MESH_SPLIT_MAX_PARTS of them. Triangles are taken in their current (cache optimized) order, so every part
+// covers a connected stretch of the mesh and only vertices on part borders are duplicated. Parts get their vertices
+// in first use order like OptimizeVertexFetch, and a copy of the textures.
+inline void SplitMesh(MeshData &mesh, vector<MeshData> &out)
+{
+    if (mesh.vertices.size() <= SHORT_INDEX_VERTEX_LIMIT
+        || mesh.vertices.size() > size_t(SHORT_INDEX_VERTEX_LIMIT) * MESH_SPLIT_MAX_PARTS)
+    {
+        out.push_back(std::move(mesh));
+        return;
+    }
+
+    const unsigned int none = ~0u;
+    vector<unsigned int> remap(mesh.vertices.size(), none);
+    vector<unsigned int> used;     // vertices remapped for the current part, to reset remap afterwards
+    MeshData part;
+    auto finishPart = [&]() {
+        part.textures = mesh.textures;
+        out.push_back(std::move(part));
+        part = MeshData();
+        for (unsigned int v : used)
+            remap[v] = none;
+        used.clear();
+    };
+
+    for (size_t t = 0; t + 2 < mesh.indices.size(); t += 3)
+    {
+        unsigned int added = 0;
+        for (int k = 0; k < 3; k++)
+            added += remap[mesh.indices[t + k]] == none;
+        if (part.vertices.size() + added > SHORT_INDEX_VERTEX_LIMIT)
+            finishPart();
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int v = mesh.indices[t + k];
+            if (remap[v] == none)
+            {
+                remap[v] = part.vertices.size();
+                part.vertices.push_back(mesh.vertices[v]);
+                used.push_back(v);
+            }
+            part.indices.push_back(remap[v]);
+        }
+    }
+    if (!part.indices.empty())
+        finishPart();
+}
+
+struct MeshOptimizationStats {
+    size_t verticesBefore = 0;
+    size_t verticesAfter = 0;
+    size_t trianglesBefore = 0;
+    size_t trianglesAfter = 0;
+    float missesBefore = 0.0f;     // cache misses (vertex shader runs) over all meshes
+    float missesAfter = 0.0f;
+    size_t lodTriangles[MESH_LOD_MAX_LEVELS] = {};     // triangles per level of detail, see GenerateLods
+
+    float acmrBefore() const { return trianglesBefore ? missesBefore / trianglesBefore : 0.0f; }
+    float acmrAfter() const { return trianglesAfter ? missesAfter / trianglesAfter : 0.0f; }
+};
+
+// runs all three passes on a freshly imported (owned, not mapped) mesh and adds its numbers to stats
+inline void OptimizeMesh(MeshData &mesh, MeshOptimizationStats &stats)
+{
+    stats.verticesBefore += mesh.vertices.size();
+    stats.trianglesBefore += mesh.indices.size() / 3;
+    stats.missesBefore += ComputeACMR(mesh.indices, mesh.vertices.size()) * (mesh.indices.size() / 3);
+
+    WeldVertices(mesh.vertices, mesh.indices);
+    OptimizeVertexCache(mesh.indices, mesh.vertices.size());
+    OptimizeVertexFetch(mesh.vertices, mesh.indices);
+
+    stats.verticesAfter += mesh.vertices.size();
+    stats.trianglesAfter += mesh.indices.size() / 3;
+    stats.missesAfter += ComputeACMR(mesh.indices, mesh.vertices.size()) * (mesh.indices.size() / 3);
+}
+#endif
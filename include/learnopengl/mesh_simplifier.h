@@ -0,0 +1,307 @@
+#ifndef MESH_SIMPLIFIER_H
+#define MESH_SIMPLIFIER_H
+
+#include <learnopengl/mesh.h>
+#include <learnopengl/mesh_optimizer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+// Import-time LOD generation by quadric error metric edge collapse (Garland and Heckbert 1997). Every collapse moves
+// a vertex onto one of its neighbours (half edge collapse), so the coarser levels only use vertices of the full mesh
+// and a level of detail is nothing but another range of the same index buffer, see MeshLod.
+//
+// Vertices on UV seams, hard normal edges and open borders are locked: the importer gives them one vertex per
+// attribute set at the same position, and collapsing any of them would tear the texture or round off the crease.
+// Interior vertices only collapse onto neighbours with a similar normal, and no collapse may flip a triangle.
+
+// triangle count of each level relative to the previous one
+const float LOD_REDUCTION = 0.5f;
+// a level is only kept if it gets below this fraction of the previous one, locked vertices can stall the reduction
+const float LOD_MIN_REDUCTION = 0.8f;
+// largest error of any level relative to the bounding sphere radius, beyond it shapes visibly melt
+const float LOD_MAX_ERROR = 0.05f;
+// a vertex only collapses onto a neighbour whose normal is within about 25 degrees of its own
+const float LOD_NORMAL_COS = 0.9f;
+// and no triangle may turn further than about 80 degrees by a collapse
+const float LOD_FLIP_COS = 0.2f;
+
+// sum of squared distances to a set of planes, each weighted by the area of the triangle it came from
+struct Quadric {
+    double a2 = 0.0, ab = 0.0, ac = 0.0, ad = 0.0, b2 = 0.0, bc = 0.0, bd = 0.0, c2 = 0.0, cd = 0.0, d2 = 0.0;
+    double weight = 0.0;
+
+    // plane dot(n, p) + d = 0 with unit n
+    void addPlane(const glm::dvec3 &n, double d, double w)
+    {
+        a2 += w * n.x * n.x; ab += w * n.x * n.y; ac += w * n.x * n.z; ad += w * n.x * d;
+        b2 += w * n.y * n.y; bc += w * n.y * n.z; bd += w * n.y * d;
+        c2 += w * n.z * n.z; cd += w * n.z * d;
+        d2 += w * d * d;
+        weight += w;
+    }
+
+    void add(const Quadric &q)
+    {
+        a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad; b2 += q.b2; bc += q.bc; bd += q.bd; c2 += q.c2; cd += q.cd; d2 += q.d2;
+        weight += q.weight;
+    }
+
+    // area weighted mean of the squared distances from p to the planes
+    double error(const glm::vec3 &p) const
+    {
+        if (weight <= 0.0)
+            return 0.0;
+        double x = p.x, y = p.y, z = p.z;
+        double e = a2 * x * x + 2.0 * ab * x * y + 2.0 * ac * x * z + 2.0 * ad * x
+                 + b2 * y * y + 2.0 * bc * y * z + 2.0 * bd * y
+                 + c2 * z * z + 2.0 * cd * z + d2;
+        return std::max(0.0, e) / weight;
+    }
+};
+
+// bounding sphere of the mesh around the center of its bounds, for LOD selection
+inline void ComputeBounds(MeshData &mesh)
+{
+    if (mesh.vertices.empty())
+        return;
+    glm::vec3 low = mesh.vertices[0].Position, high = mesh.vertices[0].Position;
+    for (const Vertex &vertex : mesh.vertices)
+    {
+        low = glm::min(low, vertex.Position);
+        high = glm::max(high, vertex.Position);
+    }
+    mesh.boundsCenter = (low + high) * 0.5f;
+    float radius = 0.0f;
+    for (const Vertex &vertex : mesh.vertices)
+        radius = std::max(radius, glm::length(vertex.Position - mesh.boundsCenter));
+    mesh.boundsRadius = radius;
+}
+
+// appends up to MESH_LOD_MAX_LEVELS - 1 simplified versions of an owned, unpacked mesh to its indices and
+// describes all levels in mesh.lods. Every level is cache optimized on its own. Adds the triangles per level to stats.
+inline void GenerateLods(MeshData &mesh, MeshOptimizationStats &stats)
+{
+    ComputeBounds(mesh);
+    const vector<Vertex> &vertices = mesh.vertices;
+    unsigned int vertexCount = vertices.size();
+    size_t triangleCount = mesh.indices.size() / 3;
+    mesh.lods.assign(1, MeshLod{0, (uint32_t)mesh.indices.size(), 0.0f});
+    stats.lodTriangles[0] += triangleCount;
+    if (triangleCount == 0 || mesh.boundsRadius <= 0.0f)
+        return;
+
+    // working copy of the triangles, collapsed vertices are replaced in place
+    vector<unsigned int> triangles(mesh.indices);
+    vector<bool> removed(triangleCount, false);
+    vector<vector<unsigned int>> vertexTriangles(vertexCount);
+    for (size_t t = 0; t < triangleCount; t++)
+        for (int k = 0; k < 3; k++)
+            vertexTriangles[triangles[3 * t + k]].push_back(t);
+
+    // locked: vertices sharing their position with another one (seams, hard edges) and vertices on an edge that isn't
+    // shared by exactly two triangles (borders, non-manifold spots). Seam edges count as borders as well, since the
+    // triangles on either side use different vertices.
+    vector<bool> locked(vertexCount, false);
+    {
+        std::unordered_map<uint64_t, unsigned int> positionUses;
+        positionUses.reserve(vertexCount);
+        vector<uint64_t> positionKeys(vertexCount);
+        for (unsigned int v = 0; v < vertexCount; v++)
+        {
+            uint32_t bits[3];
+            memcpy(bits, &vertices[v].Position[0], sizeof(bits));
+            positionKeys[v] = uint64_t(bits[0]) * 73856093ULL ^ uint64_t(bits[1]) * 19349663ULL ^ uint64_t(bits[2]) * 83492791ULL;
+            positionUses[positionKeys[v]]++;
+        }
+        for (unsigned int v = 0; v < vertexCount; v++)
+            if (positionUses[positionKeys[v]] > 1)
+                locked[v] = true;
+
+        std::unordered_map<uint64_t, unsigned int> edgeUses;
+        edgeUses.reserve(triangles.size());
+        auto edgeKey = [](unsigned int a, unsigned int b) {
+            return a < b ? uint64_t(a) << 32 | b : uint64_t(b) << 32 | a;
+        };
+        for (size_t t = 0; t < triangleCount; t++)
+            for (int k = 0; k < 3; k++)
+                edgeUses[edgeKey(triangles[3 * t + k], triangles[3 * t + (k + 1) % 3])]++;
+        for (size_t t = 0; t < triangleCount; t++)
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned int a = triangles[3 * t + k], b = triangles[3 * t + (k + 1) % 3];
+                if (edgeUses[edgeKey(a, b)] != 2)
+                    locked[a] = locked[b] = true;
+            }
+    }
+
+    vector<Quadric> quadrics(vertexCount);
+    for (size_t t = 0; t < triangleCount; t++)
+    {
+        glm::dvec3 p0(vertices[triangles[3 * t]].Position), p1(vertices[triangles[3 * t + 1]].Position),
+                   p2(vertices[triangles[3 * t + 2]].Position);
+        glm::dvec3 n = glm::cross(p1 - p0, p2 - p0);
+        double length = glm::length(n);
+        if (length <= 0.0)
+            continue;
+        n /= length;
+        for (int k = 0; k < 3; k++)
+            quadrics[triangles[3 * t + k]].addPlane(n, -glm::dot(n, p0), length * 0.5);
+    }
+
+    // distinct vertices of the live triangles around v
+    auto gatherRing = [&](unsigned int v, vector<unsigned int> &ring) {
+        ring.clear();
+        for (unsigned int t : vertexTriangles[v])
+        {
+            if (removed[t])
+                continue;
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned int w = triangles[3 * t + k];
+                if (w != v && std::find(ring.begin(), ring.end(), w) == ring.end())
+                    ring.push_back(w);
+            }
+        }
+    };
+    auto collapseCost = [&](unsigned int from, unsigned int to) {
+        Quadric q = quadrics[from];
+        q.add(quadrics[to]);
+        return q.error(vertices[to].Position);
+    };
+
+    struct Collapse {
+        double cost;
+        unsigned int from, to;
+        bool operator>(const Collapse &other) const { return cost > other.cost; }
+    };
+    std::priority_queue<Collapse, vector<Collapse>, std::greater<Collapse>> heap;
+    vector<bool> collapsed(vertexCount, false);
+    auto pushCollapse = [&](unsigned int from, unsigned int to) {
+        if (!locked[from] && !collapsed[from] && !collapsed[to]
+            && glm::dot(vertices[from].Normal, vertices[to].Normal) >= LOD_NORMAL_COS)
+            heap.push(Collapse{collapseCost(from, to), from, to});
+    };
+
+    vector<unsigned int> ring, otherRing;
+    for (unsigned int v = 0; v < vertexCount; v++)
+    {
+        if (locked[v])
+            continue;
+        gatherRing(v, ring);
+        for (unsigned int w : ring)
+            pushCollapse(v, w);
+    }
+
+    // from -> to keeps the mesh manifold (the edge has exactly two opposite vertices) and flips no triangle
+    auto canCollapse = [&](unsigned int from, unsigned int to) {
+        gatherRing(from, ring);
+        if (std::find(ring.begin(), ring.end(), to) == ring.end())
+            return false;
+        gatherRing(to, otherRing);
+        unsigned int shared = 0;
+        for (unsigned int w : ring)
+            shared += std::find(otherRing.begin(), otherRing.end(), w) != otherRing.end();
+        if (shared != 2)
+            return false;
+
+        for (unsigned int t : vertexTriangles[from])
+        {
+            const unsigned int *corners = &triangles[3 * t];
+            if (removed[t] || corners[0] == to || corners[1] == to || corners[2] == to)
+                continue;
+            glm::vec3 before[3], after[3];
+            for (int k = 0; k < 3; k++)
+            {
+                before[k] = vertices[corners[k]].Position;
+                after[k] = corners[k] == from ? vertices[to].Position : before[k];
+            }
+            glm::vec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+            glm::vec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+            float lengths = glm::length(normalBefore) * glm::length(normalAfter);
+            if (lengths <= 0.0f || glm::dot(normalBefore, normalAfter) < LOD_FLIP_COS * lengths)
+                return false;
+        }
+        return true;
+    };
+
+    size_t alive = triangleCount;
+    double maxCost = double(LOD_MAX_ERROR * mesh.boundsRadius) * double(LOD_MAX_ERROR * mesh.boundsRadius);
+    double levelCost = 0.0;
+    vector<unsigned int> lodIndices;
+    for (unsigned int level = 1; level < MESH_LOD_MAX_LEVELS; level++)
+    {
+        size_t previous = mesh.lods.back().indexCount / 3;
+        size_t target = size_t(previous * LOD_REDUCTION);
+        while (alive > target && !heap.empty() && heap.top().cost <= maxCost)
+        {
+            Collapse collapse = heap.top();
+            heap.pop();
+            unsigned int from = collapse.from, to = collapse.to;
+            if (collapsed[from] || collapsed[to])
+                continue;
+            // the quadrics changed since this was queued, try again at the current cost
+            double cost = collapseCost(from, to);
+            if (std::fabs(cost - collapse.cost) > 1e-6 * std::max(cost, collapse.cost))
+            {
+                heap.push(Collapse{cost, from, to});
+                continue;
+            }
+            if (!canCollapse(from, to))
+                continue;
+
+            for (unsigned int t : vertexTriangles[from])
+            {
+                if (removed[t])
+                    continue;
+                unsigned int *corners = &triangles[3 * t];
+                if (corners[0] == to || corners[1] == to || corners[2] == to)
+                {
+                    removed[t] = true;
+                    alive--;
+                    continue;
+                }
+                for (int k = 0; k < 3; k++)
+                    if (corners[k] == from)
+                        corners[k] = to;
+                vertexTriangles[to].push_back(t);
+            }
+            vector<unsigned int>().swap(vertexTriangles[from]);
+            vertexTriangles[to].erase(std::remove_if(vertexTriangles[to].begin(), vertexTriangles[to].end(),
+                                                     [&](unsigned int t) { return removed[t]; }),
+                                      vertexTriangles[to].end());
+            collapsed[from] = true;
+            quadrics[to].add(quadrics[from]);
+            levelCost = std::max(levelCost, cost);
+
+            // every edge touching to changed its cost
+            gatherRing(to, otherRing);
+            for (unsigned int w : otherRing)
+            {
+                pushCollapse(to, w);
+                pushCollapse(w, to);
+            }
+        }
+        if (alive > previous * LOD_MIN_REDUCTION)
+            break;
+
+        vector<unsigned int> levelIndices;
+        levelIndices.reserve(alive * 3);
+        for (size_t t = 0; t < triangleCount; t++)
+            if (!removed[t])
+                levelIndices.insert(levelIndices.end(), &triangles[3 * t], &triangles[3 * t] + 3);
+        OptimizeVertexCache(levelIndices, vertexCount);
+        mesh.lods.push_back(MeshLod{(uint32_t)(mesh.indices.size() + lodIndices.size()), (uint32_t)levelIndices.size(),
+                                    (float)std::sqrt(levelCost)});
+        lodIndices.insert(lodIndices.end(), levelIndices.begin(), levelIndices.end());
+        stats.lodTriangles[level] += alive;
+    }
+    mesh.indices.insert(mesh.indices.end(), lodIndices.begin(), lodIndices.end());
+}
+#endif
@@ -10,19 +10,81 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+#include <learnopengl/allocation_counter.h>
 #include <learnopengl/mesh.h>
+#include <learnopengl/mesh_cache.h>
+#include <learnopengl/mesh_optimizer.h>
+#include <learnopengl/mesh_simplifier.h>
+#include <learnopengl/scene_pack.h>
+#include <learnopengl/vertex_packing.h>
 #include <learnopengl/shader.h>
+#include <learnopengl/texture_loader.h>
+#include <learnopengl/texture_registry.h>
 
+#include <cctype>
+#include <cstring>
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <vector>
 using namespace std;
 
-unsigned int TextureFromFile(const char *path, const string &directory, bool gamma = false);
+unsigned int TextureFromFile(const char *path, const string &directory, Texture_Usage usage = TEXTURE_COLOR);
 
+// post-processing applied to every imported model, part of the mesh cache key
+const unsigned int MODEL_IMPORT_FLAGS = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace;
+
+inline bool IsObjFile(const string &path)
+{
+    if (path.size() < 4)
+        return false;
+    string extension = path.substr(path.size() - 4);
+    for (char &c : extension)
+        c = (char)tolower(c);
+    return extension == ".obj";
+}
+
+// material libraries an OBJ file refers to ("mtllib" lines), as paths next to the OBJ file like Assimp opens them.
+// Only the starts of the lines are looked at, for keying caches by every file an import reads.
+inline vector<string> ObjMaterialLibraries(const string &path, const unsigned char *data, size_t size)
+{
+    vector<string> libraries;
+    string directory = path.substr(0, path.find_last_of('/'));
+    const char *begin = reinterpret_cast<const char*>(data);
+    const char *end = begin + size;
+    for (const char *line = begin; line < end; )
+    {
+        const char *lineEnd = static_cast<const char*>(memchr(line, '\n', end - line));
+        if (!lineEnd)
+            lineEnd = end;
+        const char *p = line;
+        while (p < lineEnd && (*p == ' ' || *p == '\t'))
+            p++;
+        if (lineEnd - p > 6 && memcmp(p, "mtllib", 6) == 0 && (p[6] == ' ' || p[6] == '\t'))
+        {
+            // rest of the line with surrounding blanks removed
+            const char *name = p + 6, *nameEnd = lineEnd;
+            while (name < nameEnd && (*name == ' ' || *name == '\t'))
+                name++;
+            while (nameEnd > name && (nameEnd[-1] == ' ' || nameEnd[-1] == '\t' || nameEnd[-1] == '\r'))
+                nameEnd--;
+            libraries.push_back(directory + '/' + string(name, nameEnd));
+        }
+        line = lineEnd + 1;
+    }
+    return libraries;
+}
+
+// everything the CPU side of loading a model produces. Filled by Model::Import on any thread and consumed
+// by Model::Upload on the GL thread.
+struct ModelData {
+    string directory;
+    vector<MeshData> meshes;
+    MeshCache cache;                // keeps the mapping alive when meshes point into a cache file
+};
 
 
 class Model
@@ -33,11 +95,31 @@ public:
     vector<Mesh>    meshes;
     string directory;
     bool gammaCorrection;
+    Geometry_Residency residency;   // CPU side geometry kept by Upload
+    string textureNamePrefix;       // see SetShaderTextureNamePrefix
+
+    // empty model, to be filled by Upload (see ModelStreamer)
+    explicit Model(Geometry_Residency residency = GEOMETRY_DISCARD) : gammaCorrection(false), residency(residency)
+    {
+    }
 
     // constructor, expects a filepath to a 3D model.
-    Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
+    Model(string const &path, bool gamma = false, Geometry_Residency residency = GEOMETRY_DISCARD)
+        : gammaCorrection(gamma), residency(residency)
     {
-        loadModel(path);
+        ModelData data;
+        Import(path, data);
+        Upload(data);
+    }
+
+    // the model holds one registry reference per entry of textures_loaded, copies would release them twice
+    Model(const Model &) = delete;
+    Model &operator=(const Model &) = delete;
+
+    ~Model()
+    {
+        for (const Texture &texture : textures_loaded)
+            TextureRegistry::Instance().release(texture.id);
     }
 
     // draws the model, and thus all its meshes
@@ -47,33 +129,226 @@ public:
             meshes[i].Draw(shader);
     }
 
+    // draws every mesh at the level of detail its size on screen allows. model has to be the matrix the shader's
+    // model uniform is set to.
+    void Draw(Shader &shader, const glm::mat4 &model, const LodView &view)
+    {
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            meshes[i].Draw(shader, meshes[i].SelectLod(model, view));
+    }
+
+    // memory taken by the geometry: buffer objects and the CPU side copies residency keeps
+    size_t gpuGeometryBytes() const
+    {
+        size_t bytes = 0;
+        for (const Mesh &mesh : meshes)
+            bytes += mesh.bufferBytes;
+        return bytes;
+    }
+
+    size_t cpuGeometryBytes() const
+    {
+        size_t bytes = 0;
+        for (const Mesh &mesh : meshes)
+            bytes += mesh.cpuBytes();
+        return bytes;
+    }
+
     void SetShaderTextureNamePrefix(std::string prefix) {
+        textureNamePrefix = prefix;
         for (Mesh& mesh: meshes) {
-            mesh.glslIdentifierPrefix = prefix;
+            mesh.SetTextureNamePrefix(prefix);
         }
     }
+
+    // CPU side of loading: reads the model (from the scene pack, its mesh cache or else with ASSIMP) into data.
+    // Doesn't touch OpenGL, so it can run on any thread.
+    // the processed meshes are cached on disk, later runs load them from the cache and skip the importers altogether.
+    // useCaches false imports from the source regardless and rewrites the cache, for reloads after the files
+    // changed on disk.
+    static bool Import(string const &path, ModelData &data, bool useCaches = true)
+    {
+        AllocationScope allocations;
+        // retrieve the directory path of the filepath
+        data.directory = path.substr(0, path.find_last_of('/'));
+
+        // a mounted scene pack has the mesh cache built in, the source file isn't even opened
+        ScenePackSpan packed;
+        if (useCaches && ScenePack::Instance().find(path, PACK_MESHES, packed)
+            && data.cache.load(ScenePack::Instance().file(), packed.data, packed.size))
+        {
+            data.meshes = std::move(data.cache.getMeshes());
+            cout << "Model: " << path << ": scene pack, " << allocations.count() << " allocations, "
+                 << allocations.bytes() / 1024 << " KB" << endl;
+            return true;
+        }
+
+        // stamped before reading, a change while importing makes the cache look stale rather than current
+        SourceStamp stamp = StampFile(path);
+        MappedFile source(path);
+        string cachePath = CachePathFor(path, ".meshcache");
+        uint64_t cacheKey = source.isOpen() ? CacheKeyFor(path, source) : 0;
+        source.close();
+        if (useCaches && cacheKey != 0 && data.cache.load(cachePath, cacheKey))
+        {
+            data.meshes = std::move(data.cache.getMeshes());
+            cout << "Model: " << path << ": mesh cache, " << allocations.count() << " allocations, "
+                 << allocations.bytes() / 1024 << " KB" << endl;
+            return true;
+        }
+
+        if (!ReadWithAssimp(path, data.meshes))
+            return false;
+
+        // weld and reorder for the vertex caches, then add the levels of detail. The result is what goes into the mesh cache
+        MeshOptimizationStats stats;
+        vector<MeshData> optimized;
+        optimized.reserve(data.meshes.size());
+        for (MeshData &mesh : data.meshes)
+        {
+            OptimizeMesh(mesh, stats);
+            SplitMesh(mesh, optimized);
+        }
+        size_t vertexBytes = 0, packedBytes = 0, indexBytes = 0, packedIndexBytes = 0;
+        for (MeshData &mesh : optimized)
+        {
+            GenerateLods(mesh, stats);
+            vertexBytes += mesh.vertices.size() * sizeof(Vertex);
+            indexBytes += mesh.indices.size() * sizeof(unsigned int);
+            PackIndices(mesh);
+            PackVertices(mesh);
+            packedBytes += mesh.packedVertices.size();
+            packedIndexBytes += mesh.indexCount() * IndexSize(mesh.indexType);
+        }
+        data.meshes.swap(optimized);
+        cout << "MeshOptimizer: " << path << ": " << stats.verticesBefore << " -> " << stats.verticesAfter
+             << " vertices, ACMR " << stats.acmrBefore() << " -> " << stats.acmrAfter()
+             << ", vertex data " << vertexBytes / 1024 << " -> " << packedBytes / 1024 << " KB"
+             << ", index data " << indexBytes / 1024 << " -> " << packedIndexBytes / 1024 << " KB"
+             << ", LOD triangles " << stats.lodTriangles[0];
+        for (unsigned int level = 1; level < MESH_LOD_MAX_LEVELS; level++)
+            cout << " / " << stats.lodTriangles[level];
+        cout << endl;
+
+        if (cacheKey != 0 && !MeshCache::Store(cachePath, cacheKey, data.meshes, stamp))
+            cout << "WARNING::MESH_CACHE:: could not write " << cachePath << endl;
+        cout << "Model: " << path << ": imported, " << allocations.count() << " allocations, "
+             << allocations.bytes() / 1024 << " KB" << endl;
+        return true;
+    }
+
+    // mesh cache key of the model at path, whose file is mapped as source: covers the material libraries of OBJ files
+    // as well, Assimp reads them
+    static uint64_t CacheKeyFor(string const &path, const MappedFile &source)
+    {
+        if (!IsObjFile(path))
+            return MeshCache::KeyFor(source, MODEL_IMPORT_FLAGS);
+        return MeshCache::KeyFor(source, MODEL_IMPORT_FLAGS, ObjMaterialLibraries(path, source.data(), source.size()));
+    }
+
+    // bounding sphere of the model at path in model space, without importing it: from the directory of its mesh cache
+    // in the scene pack, or on disk if the model file still has the size and modification time the cache was written
+    // for. Neither the model nor its materials are read. Returns false if there is no such cache, i.e. before the
+    // first import or after the file changed.
+    static bool ReadBounds(string const &path, glm::vec3 &center, float &radius)
+    {
+        ScenePackSpan packed;
+        if (ScenePack::Instance().find(path, PACK_MESHES, packed)
+            && MeshCache::ReadBounds(packed.data, packed.size, nullptr, center, radius))
+            return true;
+
+        SourceStamp source = StampFile(path);
+        if (source.size == UINT64_MAX)
+            return false;
+        MappedFile cache(CachePathFor(path, ".meshcache"));
+        return cache.isOpen() && MeshCache::ReadBounds(cache.data(), cache.size(), &source, center, radius);
+    }
+
+    // GL side of loading: creates the buffers and textures of every imported mesh and keeps the CPU side geometry
+    // residency asks for. Has to run on the GL thread.
+    void Upload(ModelData &data)
+    {
+        directory = data.directory;
+        meshes.reserve(meshes.size() + data.meshes.size());
+        for (MeshData &meshData : data.meshes)
+        {
+            vector<Texture> textures;
+            textures.reserve(meshData.textures.size());
+            for (const Texture &texture : meshData.textures)
+                textures.push_back(loadTexture(texture.path.c_str(), texture.type));
+
+            meshes.emplace_back(meshData.vertexData(), meshData.vertexCount(), meshData.format, meshData.indexData(),
+                                meshData.indexType, meshData.indexCount(), std::move(textures));
+            KeepGeometry(meshData, residency, meshes.back());
+            meshes.back().lods = std::move(meshData.lods);
+            meshes.back().boundsCenter = meshData.boundsCenter;
+            meshes.back().boundsRadius = meshData.boundsRadius;
+            meshes.back().SetTextureNamePrefix(textureNamePrefix);
+        }
+    }
+
+    // swaps in a freshly imported version of the model (see Import), e.g. after its files changed on disk. The new
+    // buffers and textures are created before the old ones are dropped, so every draw sees either the whole old or the
+    // whole new model. GL thread only, between frames.
+    void Replace(ModelData &data)
+    {
+        Model fresh(residency);
+        fresh.gammaCorrection = gammaCorrection;
+        fresh.textureNamePrefix = textureNamePrefix;
+        fresh.Upload(data);
+        meshes.swap(fresh.meshes);
+        textures_loaded.swap(fresh.textures_loaded);
+        directory.swap(fresh.directory);
+    }
+
+    // whether a mesh draws the image at filename with another texture than the registry holds it in now (or it holds
+    // it in none), i.e. the image changed while it shared a texture with identical files (see TextureRegistry::reload)
+    bool TextureOutdated(const string &filename) const
+    {
+        string resolved = TextureRegistry::ResolvePath(filename);
+        unsigned int current = TextureRegistry::Instance().textureFor(filename);
+        for (const Mesh &mesh : meshes)
+            for (const Texture &texture : mesh.textures)
+                if (texture.id != current && TextureRegistry::ResolvePath(directory + '/' + texture.path) == resolved)
+                    return true;
+        return false;
+    }
+
+    // how a material texture is converted, see ChooseBlockFormat
+    static Texture_Usage UsageFor(const string &typeName)
+    {
+        switch (HashString(typeName))
+        {
+        case TEXTURE_TYPE_DIFFUSE:
+            return TEXTURE_COLOR;
+        case TEXTURE_TYPE_NORMAL:
+            return TEXTURE_NORMAL;
+        default:
+            return TEXTURE_DATA;
+        }
+    }
+
 private:
-    // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
-    void loadModel(string const &path)
+    // reads any format ASSIMP supports into one MeshData per mesh, in node order
+    static bool ReadWithAssimp(string const &path, vector<MeshData> &meshes)
     {
-        // read file via ASSIMP
         Assimp::Importer importer;
-        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+        const aiScene* scene = importer.ReadFile(path, MODEL_IMPORT_FLAGS);
         // check for errors
         if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
         {
             cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
-            return;
+            return false;
         }
-        // retrieve the directory path of the filepath
-        directory = path.substr(0, path.find_last_of('/'));
 
         // process ASSIMP's root node recursively
-        processNode(scene->mRootNode, scene);
+        meshes.reserve(meshes.size() + scene->mNumMeshes);
+        processNode(scene->mRootNode, scene, meshes);
+        return true;
     }
 
     // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
-    void processNode(aiNode *node, const aiScene *scene)
+    static void processNode(aiNode *node, const aiScene *scene, vector<MeshData> &meshes)
     {
         // process each mesh located at the current node
         for(unsigned int i = 0; i < node->mNumMeshes; i++)
@@ -86,70 +361,50 @@ private:
         // after we've processed all of the meshes (if any) we then recursively process each of the children nodes
         for(unsigned int i = 0; i < node->mNumChildren; i++)
         {
-            processNode(node->mChildren[i], scene);
+            processNode(node->mChildren[i], scene, meshes);
         }
 
     }
 
-    Mesh processMesh(aiMesh *mesh, const aiScene *scene)
+    static MeshData processMesh(aiMesh *mesh, const aiScene *scene)
     {
         // data to fill
-        vector<Vertex> vertices;
-        vector<unsigned int> indices;
-        vector<Texture> textures;
+        MeshData data;
+        vector<Vertex> &vertices = data.vertices;
+        vector<unsigned int> &indices = data.indices;
+        vector<Texture> &textures = data.textures;
 
-        // walk through each of the mesh's vertices
+        // walk through each of the mesh's vertices, writing them straight into their final storage
+        vertices.resize(mesh->mNumVertices);
         for(unsigned int i = 0; i < mesh->mNumVertices; i++)
         {
-            Vertex vertex;
-            glm::vec3 vector; // we declare a placeholder vector since assimp_ uses its own vector class that doesn't directly convert to glm's vec3 class so we transfer the data to this placeholder glm::vec3 first.
+            Vertex &vertex = vertices[i];
             // positions
-            vector.x = mesh->mVertices[i].x;
-            vector.y = mesh->mVertices[i].y;
-            vector.z = mesh->mVertices[i].z;
-            vertex.Position = vector;
+            vertex.Position = glm::vec3(mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z);
             // normals
             if (mesh->HasNormals())
-            {
-                vector.x = mesh->mNormals[i].x;
-                vector.y = mesh->mNormals[i].y;
-                vector.z = mesh->mNormals[i].z;
-                vertex.Normal = vector;
-            }
+                vertex.Normal = glm::vec3(mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z);
             // texture coordinates
             if(mesh->mTextureCoords[0]) // does the mesh contain texture coordinates?
             {
-                glm::vec2 vec;
                 // a vertex can contain up to 8 different texture coordinates. We thus make the assumption that we won't
                 // use models where a vertex can have multiple texture coordinates so we always take the first set (0).
-                vec.x = mesh->mTextureCoords[0][i].x;
-                vec.y = mesh->mTextureCoords[0][i].y;
-                vertex.TexCoords = vec;
+                vertex.TexCoords = glm::vec2(mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y);
                 // tangent
-                vector.x = mesh->mTangents[i].x;
-                vector.y = mesh->mTangents[i].y;
-                vector.z = mesh->mTangents[i].z;
-                vertex.Tangent = vector;
+                vertex.Tangent = glm::vec3(mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z);
                 // bitangent
-                vector.x = mesh->mBitangents[i].x;
-                vector.y = mesh->mBitangents[i].y;
-                vector.z = mesh->mBitangents[i].z;
-                vertex.Bitangent = vector;
+                vertex.Bitangent = glm::vec3(mesh->mBitangents[i].x, mesh->mBitangents[i].y, mesh->mBitangents[i].z);
             }
             else
                 vertex.TexCoords = glm::vec2(0.0f, 0.0f);
-
-            vertices.push_back(vertex);
-
-
         }
         // now wak through each of the mesh's faces (a face is a mesh its triangle) and retrieve the corresponding vertex indices.
+        indices.reserve(mesh->mNumFaces * 3);
         for(unsigned int i = 0; i < mesh->mNumFaces; i++)
         {
-            aiFace face = mesh->mFaces[i];
+            const aiFace &face = mesh->mFaces[i];
             // retrieve all indices of the face and store them in the indices vector
-            for(unsigned int j = 0; j < face.mNumIndices; j++)
-                indices.push_back(face.mIndices[j]);
+            indices.insert(indices.end(), face.mIndices, face.mIndices + face.mNumIndices);
         }
         // process materials
         aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
@@ -163,97 +418,67 @@ private:
         material->Get(AI_MATKEY_COLOR_AMBIENT, color);
 
 
+        textures.reserve(material->GetTextureCount(aiTextureType_DIFFUSE) + material->GetTextureCount(aiTextureType_SPECULAR)
+                         + material->GetTextureCount(aiTextureType_HEIGHT) + material->GetTextureCount(aiTextureType_AMBIENT));
         // 1. diffuse maps
-        vector<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
-        textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
+        materialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse", textures);
         // 2. specular maps
-        vector<Texture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
-        textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+        materialTextures(material, aiTextureType_SPECULAR, "texture_specular", textures);
         // 3. normal maps
-        std::vector<Texture> normalMaps = loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal");
-        textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
+        materialTextures(material, aiTextureType_HEIGHT, "texture_normal", textures);
         // 4. height maps
-        std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
-        textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
+        materialTextures(material, aiTextureType_AMBIENT, "texture_height", textures);
 
 
 
-        // return a mesh object created from the extracted mesh data
-        return Mesh(vertices, indices, textures);
+        // return the extracted mesh data, buffers are created on upload
+        return data;
     }
 
-    // checks all material textures of a given type and loads the textures if they're not loaded yet.
-    // the required info is returned as a Texture struct.
-    vector<Texture> loadMaterialTextures(aiMaterial *mat, aiTextureType type, string typeName)
+    // appends all material textures of a given type to textures, only type and path are filled in, the textures
+    // themselves are loaded on upload.
+    static void materialTextures(aiMaterial *mat, aiTextureType type, const char *typeName, vector<Texture> &textures)
     {
-        vector<Texture> textures;
         for(unsigned int i = 0; i < mat->GetTextureCount(type); i++)
         {
             aiString str;
             mat->GetTexture(type, i, &str);
-            // check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-            bool skip = false;
-            for(unsigned int j = 0; j < textures_loaded.size(); j++)
+            textures.push_back(Texture{0, typeName, str.C_Str()});
+        }
+    }
+
+    // returns the texture with the given path. The registry makes sure it is loaded only once per process,
+    // textures_loaded keeps a single reference per distinct texture of this model.
+    Texture loadTexture(const char *path, const string &typeName)
+    {
+        Texture texture;
+        texture.id = TextureFromFile(path, this->directory, UsageFor(typeName));
+        texture.type = typeName;
+        texture.path = path;
+        for(unsigned int j = 0; j < textures_loaded.size(); j++)
+        {
+            if(textures_loaded[j].id == texture.id)
             {
-                if(std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-                {
-                    textures.push_back(textures_loaded[j]);
-                    skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
-                    break;
-                }
-            }
-            if(!skip)
-            {   // if texture hasn't been loaded already, load it
-                Texture texture;
-                texture.id = TextureFromFile(str.C_Str(), this->directory);
-                texture.type = typeName;
-                texture.path = str.C_Str();
-                textures.push_back(texture);
-                textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecesery load duplicate textures.
+                // the model already holds this texture (possibly under another path), drop the extra reference
+                TextureRegistry::Instance().release(texture.id);
+                return textures_loaded[j];
             }
         }
-        return textures;
+        textures_loaded.push_back(texture);  // store it as texture loaded for entire model, released with the model
+        return texture;
     }
 };
 
 
-unsigned int TextureFromFile(const char *path, const string &directory, bool gamma)
+// returns a texture name right away, the image is decoded in the background and uploaded by
+// TextureLoader::update, a placeholder is bound until then. The caller owns one reference of the
+// process-wide TextureRegistry, to be given back with TextureRegistry::release.
+// usage picks mip filtering and compression, see Texture_Usage.
+unsigned int TextureFromFile(const char *path, const string &directory, Texture_Usage usage)
 {
     string filename = string(path);
     filename = directory + '/' + filename;
 
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-    if (data)
-    {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    }
-    else
-    {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
+    return TextureRegistry::Instance().acquire(filename, usage);
 }
 #endif
@@ -0,0 +1,381 @@
+#ifndef MODEL_STREAMER_H
+#define MODEL_STREAMER_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/model.h>
+#include <learnopengl/shader.h>
+#include <learnopengl/texture_loader.h>
+#include <learnopengl/thread_pool.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Loads models when the camera gets to them instead of at startup. A ModelProxy stands in for a model: creating one
+// only reads its bounding sphere (see Model::ReadBounds), the geometry and textures are loaded by the ModelStreamer
+// once an instance of it comes within MODEL_LOAD_DISTANCE of the camera, or into the view frustum within
+// MODEL_VIEW_DISTANCE. The import runs on the streamer's threads, the upload on the GL thread in update(). Models
+// nobody wants any more stay loaded until the streamer is over its memory budget, then the ones wanted longest ago
+// are unloaded first.
+//
+// reload() brings a loaded model up to date after its files changed on disk (see FileWatcher): it is imported again
+// in the background and swapped in by update() between frames, see Model::Replace.
+//
+//     ModelProxy armchairModel("resources/objects/Armchair/Armchair.obj");
+//     ModelStreamer streamer;
+//     streamer.add(armchairModel);
+//     ...
+//     // every frame
+//     armchairModel.Draw(shader, model, lodView);     // draws nothing while the model isn't loaded
+//     streamer.update(projection * view, camera.Position);
+
+// an instance this close (to its bounding sphere) is loaded whether it is in view or not, so turning around is seamless
+const float MODEL_LOAD_DISTANCE = 6.0f;
+// an instance in the view frustum is loaded up to this distance
+const float MODEL_VIEW_DISTANCE = 30.0f;
+// memory (buffers, CPU side geometry and the textures) the loaded models may take before unwanted ones are unloaded
+const size_t MODEL_MEMORY_BUDGET = 256 * 1024 * 1024;
+// imported models uploaded per update() call, the rest wait for the next frames
+const unsigned int MODEL_UPLOADS_PER_FRAME = 1;
+
+enum Model_State {
+    MODEL_UNLOADED,
+    MODEL_LOADING,      // being imported by the streamer
+    MODEL_RESIDENT,
+    MODEL_FAILED        // the import failed, not tried again
+};
+
+class ModelProxy
+{
+public:
+    explicit ModelProxy(const string &path, Geometry_Residency residency = GEOMETRY_DISCARD)
+        : path(path), residency(residency), state(MODEL_UNLOADED), lastWanted(0)
+    {
+        // a model without cheap bounds (no current mesh cache) is always wanted until its first import wrote one
+        if (!Model::ReadBounds(path, boundsCenter, boundsRadius))
+        {
+            boundsCenter = glm::vec3(0.0f);
+            boundsRadius = -1.0f;
+        }
+    }
+
+    // the streamer keeps a pointer to the proxy
+    ModelProxy(const ModelProxy &) = delete;
+    ModelProxy &operator=(const ModelProxy &) = delete;
+
+    // draws the model like Model::Draw if it is loaded. Either way the instance is recorded for the next
+    // ModelStreamer::update, which is how the streamer knows where the model is; draw every instance every frame.
+    void Draw(Shader &shader, const glm::mat4 &model, const LodView &view)
+    {
+        if (Model *instance = AddInstance(model))
+            instance->Draw(shader, model, view);
+    }
+
+    // records an instance like Draw without drawing it, for callers that draw the model themselves (see
+    // RenderQueue). Returns the loaded model, nullptr while there is none.
+    Model *AddInstance(const glm::mat4 &model)
+    {
+        if (boundsRadius >= 0.0f)
+        {
+            float scale = std::sqrt(std::max(glm::dot(model[0], model[0]), std::max(glm::dot(model[1], model[1]), glm::dot(model[2], model[2]))));
+            instances.push_back(glm::vec4(glm::vec3(model * glm::vec4(boundsCenter, 1.0f)), boundsRadius * scale));
+        }
+        return loaded.get();
+    }
+
+    void SetShaderTextureNamePrefix(std::string prefix)
+    {
+        texturePrefix = prefix;
+        if (loaded)
+            loaded->SetShaderTextureNamePrefix(prefix);
+    }
+
+    const string &getPath() const
+    {
+        return path;
+    }
+
+    Model_State getState() const
+    {
+        return state;
+    }
+
+    // the loaded model, nullptr unless the state is MODEL_RESIDENT
+    Model *getModel()
+    {
+        return loaded.get();
+    }
+
+    // memory the loaded model takes: buffers, CPU side geometry and the uploaded levels of its textures.
+    // Textures shared with other models are counted for each of them. GL thread only.
+    size_t memoryBytes() const
+    {
+        if (!loaded)
+            return 0;
+        size_t bytes = loaded->gpuGeometryBytes() + loaded->cpuGeometryBytes();
+        for (const Texture &texture : loaded->textures_loaded)
+            bytes += TextureLoader::Instance().residency(texture.id).residentBytes;
+        return bytes;
+    }
+
+private:
+    friend class ModelStreamer;
+
+    // an import in flight, shared with the task so the streamer can go away while it runs
+    struct PendingLoad {
+        ModelData data;
+        bool imported = false;
+        std::atomic<bool> done{false};
+    };
+
+    string path;
+    Geometry_Residency residency;
+    glm::vec3 boundsCenter;
+    float boundsRadius;                 // model space, negative if unknown
+    std::string texturePrefix;
+    Model_State state;
+    std::unique_ptr<Model> loaded;
+    std::shared_ptr<PendingLoad> pending;   // first load (MODEL_LOADING) or reload (MODEL_RESIDENT) in flight
+    bool stale = false;                     // the files changed while pending was being imported
+    bool bypassCaches = false;              // the files changed while not loaded, the caches may be outdated
+    std::vector<glm::vec4> instances;   // world space spheres (center, radius) drawn since the last update
+    unsigned long lastWanted;           // update() call that last wanted the model
+};
+
+class ModelStreamer
+{
+public:
+    // threadCount == 0 imports on one thread per hardware core, see ThreadPool
+    explicit ModelStreamer(size_t memoryBudget = MODEL_MEMORY_BUDGET, unsigned int threadCount = 0)
+        : memoryBudget(memoryBudget), frame(0), pool(threadCount)
+    {
+    }
+
+    // the proxy has to outlive the streamer
+    void add(ModelProxy &proxy)
+    {
+        proxies.push_back(&proxy);
+    }
+
+    // once per frame on the GL thread, after the proxies were drawn: starts loading the models that are wanted with
+    // the camera at cameraPosition looking through viewProjection, uploads finished imports and unloads what isn't
+    // wanted while over the budget.
+    void update(const glm::mat4 &viewProjection, const glm::vec3 &cameraPosition)
+    {
+        frame++;
+        // frustum planes from the rows of the matrix, pointing inwards
+        glm::vec4 planes[6];
+        for (int i = 0; i < 3; i++)
+        {
+            glm::vec4 row(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+            glm::vec4 w(viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]);
+            planes[i * 2] = w + row;
+            planes[i * 2 + 1] = w - row;
+        }
+
+        // closest first, so what the camera runs into is imported before what it only sees in the distance
+        std::vector<std::pair<float, ModelProxy*>> requests;
+        for (ModelProxy *proxy : proxies)
+        {
+            float distance;
+            if (!wanted(*proxy, planes, cameraPosition, distance))
+                continue;
+            proxy->lastWanted = frame;
+            if (proxy->state == MODEL_UNLOADED)
+                requests.push_back(std::make_pair(distance, proxy));
+        }
+        std::sort(requests.begin(), requests.end(),
+                  [](const std::pair<float, ModelProxy*> &a, const std::pair<float, ModelProxy*> &b) { return a.first < b.first; });
+        for (auto &request : requests)
+            startLoad(*request.second, !request.second->bypassCaches);
+
+        unsigned int uploads = 0;
+        for (ModelProxy *proxy : proxies)
+            if (proxy->pending && uploads < MODEL_UPLOADS_PER_FRAME && proxy->pending->done)
+                uploads += finishLoad(*proxy);
+
+        evict();
+        for (ModelProxy *proxy : proxies)
+            proxy->instances.clear();
+    }
+
+    // GL thread: the file at path changed on disk. Loaded models read from it (their model file, or any material
+    // library in their directory) are imported again, bypassing the caches, and replaced once that is done; the
+    // others load the new version whenever they are wanted next. Loaded models that draw a texture image the
+    // registry took off a shared texture (call TextureRegistry::reload first) are uploaded again, which loads it into
+    // a texture of its own. Returns false if no model uses the file.
+    bool reload(const string &path)
+    {
+        string name = ScenePack::NormalizePath(path);
+        string directory = name.substr(0, name.find_last_of('/'));
+        bool materials = name.size() > 4 && (name.compare(name.size() - 4, 4, ".mtl") == 0 || name.compare(name.size() - 4, 4, ".MTL") == 0);
+        bool used = false;
+        for (ModelProxy *proxy : proxies)
+        {
+            string proxyName = ScenePack::NormalizePath(proxy->path);
+            if (proxyName != name && !(materials && proxyName.substr(0, proxyName.find_last_of('/')) == directory))
+            {
+                // the geometry didn't change, the caches still hold it
+                if (proxy->state == MODEL_RESIDENT && !proxy->pending && proxy->loaded->TextureOutdated(path))
+                {
+                    startLoad(*proxy);
+                    used = true;
+                }
+                continue;
+            }
+            used = true;
+            if (proxy->pending)
+                proxy->stale = true;
+            else if (proxy->state == MODEL_RESIDENT)
+                startLoad(*proxy, false);
+            else
+            {
+                proxy->bypassCaches = true;
+                proxy->state = MODEL_UNLOADED;
+            }
+        }
+        return used;
+    }
+
+    // memory all loaded models take, see ModelProxy::memoryBytes. GL thread only.
+    size_t memoryBytes() const
+    {
+        size_t bytes = 0;
+        for (const ModelProxy *proxy : proxies)
+            bytes += proxy->memoryBytes();
+        return bytes;
+    }
+
+private:
+    size_t memoryBudget;
+    unsigned long frame;
+    std::vector<ModelProxy*> proxies;
+    // last, so the workers are joined before anything they could touch goes away
+    ThreadPool pool;
+
+    bool wanted(const ModelProxy &proxy, const glm::vec4 planes[6], const glm::vec3 &cameraPosition, float &distance) const
+    {
+        if (proxy.boundsRadius < 0.0f)
+        {
+            distance = 0.0f;
+            return true;
+        }
+        bool found = false;
+        for (const glm::vec4 &sphere : proxy.instances)
+        {
+            glm::vec3 center(sphere);
+            float instanceDistance = std::max(0.0f, glm::length(center - cameraPosition) - sphere.w);
+            bool inView = instanceDistance <= MODEL_VIEW_DISTANCE;
+            for (int i = 0; i < 6 && inView; i++)
+                inView = glm::dot(glm::vec3(planes[i]), center) + planes[i].w >= -sphere.w * glm::length(glm::vec3(planes[i]));
+            if (instanceDistance <= MODEL_LOAD_DISTANCE || inView)
+            {
+                distance = found ? std::min(distance, instanceDistance) : instanceDistance;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    // imports the model on the pool. A resident model stays as it is until the import is done (a reload),
+    // useCaches as in Model::Import.
+    void startLoad(ModelProxy &proxy, bool useCaches = true)
+    {
+        std::shared_ptr<ModelProxy::PendingLoad> load = std::make_shared<ModelProxy::PendingLoad>();
+        string path = proxy.path;
+        pool.enqueue([load, path, useCaches]() {
+            load->imported = Model::Import(path, load->data, useCaches);
+            load->done = true;
+        });
+        proxy.pending = load;
+        proxy.stale = false;
+        proxy.bypassCaches = false;
+        if (proxy.state != MODEL_RESIDENT)
+            proxy.state = MODEL_LOADING;
+    }
+
+    bool finishLoad(ModelProxy &proxy)
+    {
+        std::shared_ptr<ModelProxy::PendingLoad> load = std::move(proxy.pending);
+        bool uploaded = false;
+        if (proxy.state == MODEL_RESIDENT)
+        {
+            // a reload, a failed one keeps the old version
+            if (load->imported)
+            {
+                proxy.loaded->Replace(load->data);
+                if (!Model::ReadBounds(proxy.path, proxy.boundsCenter, proxy.boundsRadius))
+                    proxy.boundsRadius = -1.0f;
+                std::cout << "ModelStreamer: " << proxy.path << ": reloaded, " << proxy.memoryBytes() / 1024 << " KB" << std::endl;
+                uploaded = true;
+            }
+            else
+                std::cout << "ERROR::MODEL_STREAMER:: could not reload " << proxy.path << std::endl;
+        }
+        else if (load->imported)
+        {
+            proxy.loaded.reset(new Model(proxy.residency));
+            proxy.loaded->SetShaderTextureNamePrefix(proxy.texturePrefix);
+            proxy.loaded->Upload(load->data);
+            proxy.state = MODEL_RESIDENT;
+            if (proxy.boundsRadius < 0.0f)
+                Model::ReadBounds(proxy.path, proxy.boundsCenter, proxy.boundsRadius);
+            std::cout << "ModelStreamer: " << proxy.path << ": loaded, " << proxy.memoryBytes() / 1024 << " KB" << std::endl;
+            uploaded = true;
+        }
+        else
+        {
+            std::cout << "ERROR::MODEL_STREAMER:: could not load " << proxy.path << std::endl;
+            proxy.state = MODEL_FAILED;
+        }
+
+        // changed again while importing: what was just uploaded is already outdated
+        if (proxy.stale)
+        {
+            if (proxy.state == MODEL_RESIDENT)
+                startLoad(proxy, false);
+            else
+            {
+                proxy.bypassCaches = true;
+                proxy.state = MODEL_UNLOADED;
+            }
+        }
+        return uploaded;
+    }
+
+    // unloads the resident models not wanted this frame, least recently wanted first, until under the budget
+    void evict()
+    {
+        size_t bytes = memoryBytes();
+        if (bytes <= memoryBudget)
+            return;
+        std::vector<ModelProxy*> candidates;
+        for (ModelProxy *proxy : proxies)
+            if (proxy->state == MODEL_RESIDENT && proxy->lastWanted != frame)
+                candidates.push_back(proxy);
+        std::sort(candidates.begin(), candidates.end(),
+                  [](const ModelProxy *a, const ModelProxy *b) { return a->lastWanted < b->lastWanted; });
+        for (ModelProxy *proxy : candidates)
+        {
+            if (bytes <= memoryBudget)
+                break;
+            size_t freed = proxy->memoryBytes();
+            bytes -= std::min(bytes, freed);
+            proxy->loaded.reset();
+            // a reload in flight, its task finishes on its own. The files changed since the caches were written.
+            if (proxy->pending)
+                proxy->bypassCaches = true;
+            proxy->pending.reset();
+            proxy->stale = false;
+            proxy->state = MODEL_UNLOADED;
+            std::cout << "ModelStreamer: " << proxy->path << ": unloaded, " << freed / 1024 << " KB" << std::endl;
+        }
+    }
+};
+#endif
@@ -0,0 +1,222 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/gl_extensions.h>
+#include <learnopengl/hash.h>
+#include <learnopengl/mapped_file.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Cache of linked shader programs (glGetProgramBinary / glProgramBinary, GL 4.1 or ARB_get_program_binary), so a
+// warm start skips compiling and linking. A cache file is keyed by the sources and the driver (vendor, renderer and
+// version strings): a driver update or an edited shader simply misses. Drivers may still reject a binary they
+// wrote themselves, the program is then compiled from source as if there was no cache and the file rewritten.
+//
+// layout: ProgramCacheHeader | binary (format as reported by the driver)
+// Bump PROGRAM_CACHE_VERSION whenever the layout changes.
+const uint32_t PROGRAM_CACHE_VERSION = 1;
+const char PROGRAM_CACHE_MAGIC[8] = {'P', 'R', 'G', 'C', 'A', 'C', 'H', '\0'};
+
+#ifndef GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH           0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS      0x87FE
+#endif
+typedef void (APIENTRYP PFNGLGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
+typedef void (APIENTRYP PFNGLPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+
+struct ProgramCacheHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t format;            // binaryFormat of glGetProgramBinary
+    uint64_t key;
+    uint64_t compileMicroseconds;   // what building the program from source took, for the savings report
+    uint64_t size;
+};
+
+// what the cache did since startup, see ProgramCache::report
+struct ProgramCacheStats {
+    unsigned int loaded = 0;        // programs taken from the cache
+    unsigned int compiled = 0;      // programs built from source (cache miss, rejected binary or no support)
+    unsigned int rejected = 0;      // cached binaries the driver refused
+    double loadMs = 0.0;
+    double compileMs = 0.0;
+    double savedMs = 0.0;           // compile time recorded with the loaded binaries minus their load time
+};
+
+class ProgramCache
+{
+public:
+    static ProgramCache &Instance()
+    {
+        static ProgramCache instance;
+        return instance;
+    }
+
+    ProgramCache(const ProgramCache &) = delete;
+    ProgramCache &operator=(const ProgramCache &) = delete;
+
+    // GL thread: true if the driver can hand out program binaries. Loads the entry points on the first call,
+    // needs SetExtensionLoader.
+    bool isSupported()
+    {
+        if (!checked)
+        {
+            checked = true;
+            GLint major = 0, minor = 0, formats = 0;
+            glGetIntegerv(GL_MAJOR_VERSION, &major);
+            glGetIntegerv(GL_MINOR_VERSION, &minor);
+            if (major > 4 || (major == 4 && minor >= 1) || HasExtension("GL_ARB_get_program_binary"))
+            {
+                getProgramBinary = LoadExtensionFunction<PFNGLGETPROGRAMBINARYPROC>("glGetProgramBinary");
+                programBinary = LoadExtensionFunction<PFNGLPROGRAMBINARYPROC>("glProgramBinary");
+                programParameteri = LoadExtensionFunction<PFNGLPROGRAMPARAMETERIPROC>("glProgramParameteri");
+                glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+            }
+            supported = getProgramBinary && programBinary && programParameteri && formats > 0;
+        }
+        return supported;
+    }
+
+    // key of a program: its sources and the driver that compiles them
+    static uint64_t KeyFor(const char *vertexCode, size_t vertexLength, const char *fragmentCode, size_t fragmentLength)
+    {
+        uint64_t key = HashValue(PROGRAM_CACHE_VERSION);
+        key = HashBytes(vertexCode, vertexLength, HashValue(vertexLength, key));
+        key = HashBytes(fragmentCode, fragmentLength, HashValue(fragmentLength, key));
+        for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION})
+        {
+            const char *value = reinterpret_cast<const char*>(glGetString(name));
+            key = HashString(value ? value : "", key);
+        }
+        return key;
+    }
+
+    // cache file of the program built from the two shader files with the given defines (see Shader)
+    static std::string PathFor(const std::string &vertexPath, const std::string &fragmentPath,
+                               const std::vector<std::string> &defines = std::vector<std::string>())
+    {
+        std::string name = vertexPath + "+" + fragmentPath;
+        for (const std::string &define : defines)
+            name += "+" + define;
+        std::replace(name.begin(), name.end(), ' ', '_');
+        return CachePathFor(name, ".program");
+    }
+
+    // GL thread: gives program the cached binary, true if the driver linked it. False leaves program unlinked,
+    // to be built from source.
+    bool load(unsigned int program, const std::string &cachePath, uint64_t key)
+    {
+        if (!isSupported())
+            return false;
+        auto start = std::chrono::steady_clock::now();
+        MappedFile file(cachePath);
+        if (!file.isOpen() || file.size() < sizeof(ProgramCacheHeader))
+            return false;
+        ProgramCacheHeader header;
+        memcpy(&header, file.data(), sizeof(header));
+        if (memcmp(header.magic, PROGRAM_CACHE_MAGIC, sizeof(header.magic)) != 0 || header.version != PROGRAM_CACHE_VERSION
+            || header.key != key || header.size != file.size() - sizeof(header))
+            return false;
+
+        programBinary(program, header.format, file.data() + sizeof(header), header.size);
+        GLint linked = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked)
+        {
+            stats.rejected++;
+            return false;
+        }
+        double ms = milliseconds(start);
+        stats.loaded++;
+        stats.loadMs += ms;
+        stats.savedMs += header.compileMicroseconds / 1000.0 - ms;
+        return true;
+    }
+
+    // GL thread: call before linking a program that is going to be stored, some drivers only keep binaries of
+    // programs that asked for it
+    void prepare(unsigned int program)
+    {
+        if (isSupported())
+            programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+
+    // GL thread: writes the binary of a linked program, compileMs is what building it took. A failure only means
+    // the next start compiles again.
+    void store(unsigned int program, const std::string &cachePath, uint64_t key, double compileMs)
+    {
+        stats.compiled++;
+        stats.compileMs += compileMs;
+        if (!isSupported())
+            return;
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length <= 0)
+            return;
+        std::vector<unsigned char> blob(sizeof(ProgramCacheHeader) + length);
+        GLenum format = 0;
+        GLsizei written = 0;
+        getProgramBinary(program, length, &written, &format, blob.data() + sizeof(ProgramCacheHeader));
+        if (written <= 0)
+            return;
+
+        ProgramCacheHeader header;
+        memcpy(header.magic, PROGRAM_CACHE_MAGIC, sizeof(header.magic));
+        header.version = PROGRAM_CACHE_VERSION;
+        header.format = format;
+        header.key = key;
+        header.compileMicroseconds = uint64_t(compileMs * 1000.0);
+        header.size = written;
+        memcpy(blob.data(), &header, sizeof(header));
+        if (!WriteFileAtomic(cachePath, blob.data(), sizeof(header) + written))
+            std::cout << "WARNING::PROGRAM_CACHE:: could not write " << cachePath << std::endl;
+    }
+
+    const ProgramCacheStats &getStats() const
+    {
+        return stats;
+    }
+
+    // prints what the cache saved so far, once all programs of the scene are built
+    void report() const
+    {
+        std::cout << "ProgramCache: " << stats.loaded + stats.compiled << " programs, " << stats.loaded << " from cache ("
+                  << stats.loadMs << " ms, about " << (stats.savedMs > 0.0 ? stats.savedMs : 0.0) << " ms saved), "
+                  << stats.compiled << " compiled (" << stats.compileMs << " ms)";
+        if (stats.rejected > 0)
+            std::cout << ", " << stats.rejected << " cached binaries rejected by the driver";
+        if (!supported)
+            std::cout << ", program binaries not supported";
+        std::cout << std::endl;
+    }
+
+    static double milliseconds(std::chrono::steady_clock::time_point start)
+    {
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count();
+    }
+
+private:
+    bool checked;
+    bool supported;
+    PFNGLGETPROGRAMBINARYPROC getProgramBinary;
+    PFNGLPROGRAMBINARYPROC programBinary;
+    PFNGLPROGRAMPARAMETERIPROC programParameteri;
+    ProgramCacheStats stats;
+
+    ProgramCache() : checked(false), supported(false), getProgramBinary(nullptr), programBinary(nullptr),
+                     programParameteri(nullptr)
+    {
+    }
+};
+#endif
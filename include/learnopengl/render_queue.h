@@ -0,0 +1,277 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/mesh.h>
+#include <learnopengl/model.h>
+#include <learnopengl/shader.h>
+#include <learnopengl/uniform.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Draws of a frame collected, sorted by a 64-bit key and issued with as few state changes as the order allows.
+// Opaque draws are grouped by program, material and vertex array and go front to back within a group, transparent
+// draws go back to front whatever their state. The pass comes first, so culled opaque draws, opaque draws without
+// culling and transparent draws switch face culling at most twice:
+//
+//   opaque       pass:2 | program:10 | material:14 | vertex array:14 | depth:24
+//   transparent  pass:2 | inverted depth:24 | program:10 | material:14 | vertex array:14
+//
+// Programs, materials and vertex arrays are numbered in the order the frame first submits them, depth is the
+// distance to the camera relative to the far plane. A field that runs out of bits only sorts worse, execute()
+// compares the actual state and never skips a change it needs.
+//
+//     queue.begin(camera.Position, 100.0f);
+//     queue.submit(RENDER_OPAQUE, shader, modelUniform, model, &material, VAO, 36);
+//     queue.submit(RENDER_OPAQUE, modelShader, modelUniform, model, *loadedModel, lodView);
+//     queue.execute();
+
+// in the order they are drawn
+enum Render_Pass {
+    RENDER_OPAQUE,                  // face culling on, for closed shapes with their faces wound counter-clockwise
+    RENDER_OPAQUE_DOUBLE_SIDED,     // face culling off, e.g. models with open or inconsistently wound geometry
+    RENDER_TRANSPARENT              // blended, seen from both sides
+};
+
+// textures of a draw that isn't a mesh, bound to units 0 (material.diffuse) and 1 (material.specular) of the lit
+// shaders. Draws are grouped by the address of their material, share one object between draws with the same
+// textures.
+struct RenderMaterial {
+    unsigned int diffuse;
+    unsigned int specular;
+};
+
+// state changes of the last execute()
+struct RenderQueueStats {
+    unsigned int draws = 0;
+    unsigned int programChanges = 0;
+    unsigned int materialChanges = 0;
+    unsigned int vertexArrayChanges = 0;
+};
+
+struct RenderKey {
+    uint64_t key;
+    uint32_t command;
+};
+
+// stable LSD radix sort by key, 8 bits per pass. Bytes that are the same in every key are skipped, the keys of a
+// frame with few programs and materials sort in a few passes.
+inline void RadixSort(std::vector<RenderKey> &keys, std::vector<RenderKey> &scratch)
+{
+    size_t counts[8][256] = {};
+    for (const RenderKey &key : keys)
+        for (unsigned int digit = 0; digit < 8; digit++)
+            counts[digit][(key.key >> (digit * 8)) & 0xFF]++;
+
+    scratch.resize(keys.size());
+    for (unsigned int digit = 0; digit < 8; digit++)
+    {
+        size_t *count = counts[digit];
+        if (count[(keys.empty() ? 0 : keys[0].key >> (digit * 8)) & 0xFF] == keys.size())
+            continue;
+        size_t offset = 0;
+        for (unsigned int bucket = 0; bucket < 256; bucket++)
+        {
+            size_t bucketSize = count[bucket];
+            count[bucket] = offset;
+            offset += bucketSize;
+        }
+        for (const RenderKey &key : keys)
+            scratch[count[(key.key >> (digit * 8)) & 0xFF]++] = key;
+        keys.swap(scratch);
+    }
+}
+
+class RenderQueue
+{
+public:
+    // field widths of the key, see above
+    static const unsigned int PROGRAM_BITS = 10;
+    static const unsigned int MATERIAL_BITS = 14;
+    static const unsigned int VERTEX_ARRAY_BITS = 14;
+    static const unsigned int DEPTH_BITS = 24;
+
+    RenderQueue() : cameraPosition(0.0f), farPlane(1.0f)
+    {
+    }
+
+    // starts the frame's list, depth is measured from cameraPosition up to farPlane
+    void begin(const glm::vec3 &cameraPosition, float farPlane)
+    {
+        this->cameraPosition = cameraPosition;
+        this->farPlane = farPlane;
+        commands.clear();
+        keys.clear();
+        programs.clear();
+        materials.clear();
+        vertexArrays.clear();
+    }
+
+    // count vertices of vertexArray drawn as triangles with material bound (nullptr for none). Its depth is that of
+    // the origin of model.
+    void submit(Render_Pass pass, Shader &shader, Uniform<glm::mat4> modelUniform, const glm::mat4 &model,
+                const RenderMaterial *material, unsigned int vertexArray, GLsizei count)
+    {
+        RenderCommand command;
+        command.shader = &shader;
+        command.modelUniform = modelUniform;
+        command.model = model;
+        command.material = material;
+        command.mesh = nullptr;
+        command.vertexArray = vertexArray;
+        command.count = count;
+        command.lod = 0;
+        add(pass, command, glm::vec3(model[3]));
+    }
+
+    // every mesh of a loaded model at the level of detail its size on screen allows (see Model::Draw), each with
+    // the depth of its bounding sphere's center
+    void submit(Render_Pass pass, Shader &shader, Uniform<glm::mat4> modelUniform, const glm::mat4 &model,
+                Model &loaded, const LodView &view)
+    {
+        for (Mesh &mesh : loaded.meshes)
+        {
+            RenderCommand command;
+            command.shader = &shader;
+            command.modelUniform = modelUniform;
+            command.model = model;
+            command.material = nullptr;
+            command.mesh = &mesh;
+            command.vertexArray = mesh.VAO;
+            command.count = 0;
+            command.lod = mesh.SelectLod(model, view);
+            add(pass, command, glm::vec3(model * glm::vec4(mesh.boundsCenter, 1.0f)));
+        }
+    }
+
+    // GL thread: sorts the frame's draws and issues them, leaving no vertex array bound
+    void execute()
+    {
+        RadixSort(keys, scratch);
+        stats = RenderQueueStats();
+
+        unsigned int program = 0;
+        const void *material = nullptr;
+        bool materialBound = false;
+        unsigned int vertexArray = 0;
+        int culling = -1;
+        for (const RenderKey &key : keys)
+        {
+            const RenderCommand &command = commands[key.command];
+            int commandCulling = int(key.key >> 62) == RENDER_OPAQUE;
+            if (commandCulling != culling)
+            {
+                culling = commandCulling;
+                if (culling)
+                    glEnable(GL_CULL_FACE);
+                else
+                    glDisable(GL_CULL_FACE);
+            }
+            // sampler uniforms belong to the program, a new one needs the material again
+            if (command.shader->ID != program)
+            {
+                command.shader->use();
+                program = command.shader->ID;
+                materialBound = false;
+                stats.programChanges++;
+            }
+            const void *commandMaterial = materialOf(command);
+            if (!materialBound || commandMaterial != material)
+            {
+                if (command.mesh)
+                    command.mesh->Bind(*command.shader);
+                else if (command.material)
+                {
+                    glActiveTexture(GL_TEXTURE0);
+                    glBindTexture(GL_TEXTURE_2D, command.material->diffuse);
+                    glActiveTexture(GL_TEXTURE1);
+                    glBindTexture(GL_TEXTURE_2D, command.material->specular);
+                }
+                material = commandMaterial;
+                materialBound = true;
+                stats.materialChanges++;
+            }
+            if (command.vertexArray != vertexArray)
+            {
+                glBindVertexArray(command.vertexArray);
+                vertexArray = command.vertexArray;
+                stats.vertexArrayChanges++;
+            }
+
+            command.modelUniform.set(command.model);
+            if (command.mesh)
+                command.mesh->DrawElements(command.lod);
+            else
+                glDrawArrays(GL_TRIANGLES, 0, command.count);
+            stats.draws++;
+        }
+        glBindVertexArray(0);
+        glActiveTexture(GL_TEXTURE0);
+    }
+
+    const RenderQueueStats &getStats() const
+    {
+        return stats;
+    }
+
+private:
+    struct RenderCommand {
+        Shader *shader;
+        Uniform<glm::mat4> modelUniform;
+        glm::mat4 model;
+        const RenderMaterial *material;
+        Mesh *mesh;                 // draws itself and binds its own textures, material is unused then
+        unsigned int vertexArray;
+        GLsizei count;
+        unsigned int lod;
+    };
+
+    glm::vec3 cameraPosition;
+    float farPlane;
+    std::vector<RenderCommand> commands;
+    std::vector<RenderKey> keys;
+    std::vector<RenderKey> scratch;
+    // numbers of the programs, materials and vertex arrays of this frame, in submission order
+    std::unordered_map<uintptr_t, uint32_t> programs;
+    std::unordered_map<uintptr_t, uint32_t> materials;
+    std::unordered_map<uintptr_t, uint32_t> vertexArrays;
+    RenderQueueStats stats;
+
+    static const void *materialOf(const RenderCommand &command)
+    {
+        return command.mesh ? static_cast<const void*>(command.mesh) : command.material;
+    }
+
+    void add(Render_Pass pass, const RenderCommand &command, const glm::vec3 &position)
+    {
+        const uint64_t depthMax = (1ULL << DEPTH_BITS) - 1;
+        float distance = std::min(glm::length(position - cameraPosition) / farPlane, 1.0f);
+        uint64_t depth = uint64_t(distance * depthMax);
+        uint64_t state = (number(programs, command.shader->ID, PROGRAM_BITS) << (MATERIAL_BITS + VERTEX_ARRAY_BITS))
+                       | (number(materials, uintptr_t(materialOf(command)), MATERIAL_BITS) << VERTEX_ARRAY_BITS)
+                       | number(vertexArrays, command.vertexArray, VERTEX_ARRAY_BITS);
+        uint64_t key = uint64_t(pass) << 62;
+        if (pass != RENDER_TRANSPARENT)
+            key |= (state << DEPTH_BITS) | depth;
+        else
+            key |= ((depthMax - depth) << (PROGRAM_BITS + MATERIAL_BITS + VERTEX_ARRAY_BITS)) | state;
+        keys.push_back(RenderKey{key, uint32_t(commands.size())});
+        commands.push_back(command);
+    }
+
+    // number of value in this frame, the last one the field can hold for everything past it
+    static uint64_t number(std::unordered_map<uintptr_t, uint32_t> &numbers, uintptr_t value, unsigned int bits)
+    {
+        auto found = numbers.find(value);
+        if (found == numbers.end())
+            found = numbers.emplace(value, uint32_t(numbers.size())).first;
+        return std::min<uint64_t>(found->second, (1ULL << bits) - 1);
+    }
+};
+#endif
@@ -0,0 +1,371 @@
+#ifndef SCENE_PACK_H
+#define SCENE_PACK_H
+
+#include <learnopengl/hash.h>
+#include <learnopengl/mapped_file.h>
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// One archive with everything a scene reads at startup: the mesh cache of every model, every texture as a .ktx with
+// its mip chain, and the shader sources. CookScenePack (scene_pack_cooker.h) writes it; at runtime
+// ScenePack::Instance().mount() maps it once, and Model::Import, the texture loader and Shader look their files up
+// in it before going to the file system. What find() hands out points into the mapping, nothing is copied.
+//
+// layout: ScenePackHeader | ScenePackEntry[entryCount] sorted by nameHash | ScenePackSource[sourceCount] | names |
+// payloads
+// every payload starts on a SCENE_PACK_ALIGNMENT boundary, so mesh caches and KTX levels can be used in place.
+// Bump SCENE_PACK_VERSION whenever the layout changes. The payloads carry their own versions (mesh cache version,
+// texture cache key), an outdated payload is ignored and that one file is loaded the usual way.
+// Every entry lists the files it was cooked from with their size and modification time. mount() drops the entries
+// whose sources changed since (edited while the viewer was closed, or hot reloaded in an earlier session), those
+// files are loaded from the sources until the cooker runs again.
+const uint32_t SCENE_PACK_VERSION   = 3;
+const uint32_t SCENE_PACK_ALIGNMENT = 64;
+const char SCENE_PACK_MAGIC[8] = {'S', 'C', 'N', 'P', 'A', 'C', 'K', '\0'};
+
+// default location of the pack of the scene in main.cpp
+const char * const SCENE_PACK_PATH = "cache/scene.pack";
+
+// what a pack entry holds, lookups only match entries of the requested kind
+enum Pack_Entry_Kind {
+    PACK_MESHES,        // mesh cache (see MeshCache) of the model file the entry is named after
+    PACK_TEXTURE,       // KTX file with the converted source image
+    PACK_SHADER         // shader source, as is
+};
+
+struct ScenePackHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t entryCount;
+    uint64_t key;           // HashContent of everything after the header, tells the cooker if a rewrite would change anything
+    uint32_t sourceCount;
+    uint32_t reserved;
+};
+
+struct ScenePackEntry {
+    uint64_t nameHash;
+    uint64_t offset;
+    uint64_t size;
+    uint64_t contentHash;   // HashContent of the source file (for meshes: the mesh cache key)
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    uint32_t kind;
+    uint32_t sourceCount;   // sources of this entry, from sourceIndex on
+    uint32_t sourceIndex;
+    uint32_t reserved;
+};
+
+// a file an entry was cooked from, as it was then
+struct ScenePackSource {
+    uint64_t size;
+    int64_t  modified;      // nanoseconds
+    uint32_t nameOffset;
+    uint32_t nameLength;
+};
+
+// size and modification time of a file, to tell later whether it changed. A missing file has a stamp of its own.
+struct SourceStamp {
+    std::string path;
+    uint64_t size;
+    int64_t modified;
+};
+
+inline SourceStamp StampFile(const std::string &path)
+{
+    SourceStamp stamp{path, UINT64_MAX, 0};
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0)
+    {
+        stamp.size = uint64_t(st.st_size);
+#ifdef __APPLE__
+        stamp.modified = int64_t(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+        stamp.modified = int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+    }
+    return stamp;
+}
+
+// a file inside a mounted pack
+struct ScenePackSpan {
+    const unsigned char *data = nullptr;
+    size_t size = 0;
+    uint64_t contentHash = 0;
+};
+
+class ScenePack
+{
+public:
+    static ScenePack &Instance()
+    {
+        static ScenePack instance;
+        return instance;
+    }
+
+    ScenePack(const ScenePack &) = delete;
+    ScenePack &operator=(const ScenePack &) = delete;
+
+    // maps the pack at path and validates its directory, returns false (leaving nothing mounted) if it is missing
+    // or unusable. Entries whose sources changed after cooking are left out.
+    // Call before any loading starts, lookups from other threads are only safe while nobody mounts.
+    bool mount(const std::string &path)
+    {
+        unmount();
+        std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>(path);
+        if (!file->isOpen() || file->size() < sizeof(ScenePackHeader))
+            return false;
+
+        ScenePackHeader header;
+        memcpy(&header, file->data(), sizeof(header));
+        if (memcmp(header.magic, SCENE_PACK_MAGIC, sizeof(header.magic)) != 0 || header.version != SCENE_PACK_VERSION
+            || sizeof(ScenePackHeader) + uint64_t(header.entryCount) * sizeof(ScenePackEntry)
+               + uint64_t(header.sourceCount) * sizeof(ScenePackSource) > file->size())
+        {
+            std::cout << "WARNING::SCENE_PACK:: " << path << " is not a scene pack of this version or is truncated" << std::endl;
+            return false;
+        }
+        const ScenePackEntry *first = reinterpret_cast<const ScenePackEntry*>(file->data() + sizeof(ScenePackHeader));
+        const ScenePackSource *sources = reinterpret_cast<const ScenePackSource*>(first + header.entryCount);
+        for (uint32_t i = 0; i < header.entryCount; i++)
+        {
+            const ScenePackEntry &entry = first[i];
+            if (entry.offset + entry.size > file->size() || uint64_t(entry.nameOffset) + entry.nameLength > file->size()
+                || uint64_t(entry.sourceIndex) + entry.sourceCount > header.sourceCount
+                || (i > 0 && first[i - 1].nameHash > entry.nameHash))
+            {
+                std::cout << "WARNING::SCENE_PACK:: " << path << " is damaged" << std::endl;
+                return false;
+            }
+        }
+        for (uint32_t i = 0; i < header.sourceCount; i++)
+        {
+            if (uint64_t(sources[i].nameOffset) + sources[i].nameLength > file->size())
+            {
+                std::cout << "WARNING::SCENE_PACK:: " << path << " is damaged" << std::endl;
+                return false;
+            }
+        }
+
+        // entries cooked from files that have changed since are as good as invalidated
+        std::unordered_set<std::string> stale;
+        for (uint32_t i = 0; i < header.entryCount; i++)
+        {
+            const ScenePackEntry &entry = first[i];
+            for (uint32_t j = entry.sourceIndex; j < entry.sourceIndex + entry.sourceCount; j++)
+            {
+                std::string sourcePath(reinterpret_cast<const char*>(file->data()) + sources[j].nameOffset, sources[j].nameLength);
+                SourceStamp stamp = StampFile(sourcePath);
+                if (stamp.size != sources[j].size || stamp.modified != sources[j].modified)
+                {
+                    stale.insert(std::string(reinterpret_cast<const char*>(file->data()) + entry.nameOffset, entry.nameLength));
+                    break;
+                }
+            }
+        }
+
+        mapping = file;
+        entries = first;
+        {
+            std::lock_guard<std::mutex> lock(invalidatedMutex);
+            invalidated.swap(stale);
+            anyInvalidated = !invalidated.empty();
+        }
+        entryCount = header.entryCount;
+        std::cout << "ScenePack: " << path << ": " << entryCount << " files, " << mapping->size() / 1024 << " KB";
+        if (anyInvalidated)
+            std::cout << ", " << invalidated.size() << " out of date (sources changed since cooking), loaded from the sources";
+        std::cout << std::endl;
+        return true;
+    }
+
+    // drops the pack. Whatever was loaded from it stays valid, the loaders keep the mapping alive where they need it.
+    void unmount()
+    {
+        mapping.reset();
+        entries = nullptr;
+        entryCount = 0;
+    }
+
+    bool isMounted() const
+    {
+        return mapping != nullptr;
+    }
+
+    // looks up the file a loader was asked for, by its path as the program spells it (see NormalizePath)
+    bool find(const std::string &path, Pack_Entry_Kind kind, ScenePackSpan &span) const
+    {
+        if (!mapping)
+            return false;
+        std::string name = NormalizePath(path);
+        uint64_t nameHash = HashString(name);
+        const ScenePackEntry *end = entries + entryCount;
+        const ScenePackEntry *entry = std::lower_bound(entries, end, nameHash,
+            [](const ScenePackEntry &e, uint64_t hash) { return e.nameHash < hash; });
+        for (; entry != end && entry->nameHash == nameHash; entry++)
+        {
+            if (entry->kind != uint32_t(kind) || entry->nameLength != name.size()
+                || memcmp(mapping->data() + entry->nameOffset, name.data(), name.size()) != 0)
+                continue;
+            if (anyInvalidated)
+            {
+                std::lock_guard<std::mutex> lock(invalidatedMutex);
+                if (invalidated.count(name))
+                    return false;
+            }
+            span.data = mapping->data() + entry->offset;
+            span.size = entry->size;
+            span.contentHash = entry->contentHash;
+            return true;
+        }
+        return false;
+    }
+
+    // the file at path changed after the pack was cooked (see FileWatcher): from now on find() doesn't return it
+    // any more, whatever loads it next goes to the file system. Any thread.
+    void invalidate(const std::string &path)
+    {
+        std::lock_guard<std::mutex> lock(invalidatedMutex);
+        invalidated.insert(NormalizePath(path));
+        anyInvalidated = true;
+    }
+
+    // the mapping the spans of find() point into, for loaders that hand the data on beyond the current call
+    std::shared_ptr<MappedFile> file() const
+    {
+        return mapping;
+    }
+
+    // the name a file is stored under: its path with "." and empty components removed and "dir/.." collapsed,
+    // without touching the file system. "resources/objects/Armchair/./Armchair.jpg" and
+    // "resources/objects/Armchair/Armchair.jpg" are the same entry.
+    static std::string NormalizePath(const std::string &path)
+    {
+        std::vector<std::string> parts;
+        size_t start = 0;
+        while (start <= path.size())
+        {
+            size_t slash = path.find_first_of("/\\", start);
+            if (slash == std::string::npos)
+                slash = path.size();
+            std::string part = path.substr(start, slash - start);
+            if (part == ".." && !parts.empty() && parts.back() != "..")
+                parts.pop_back();
+            else if (!part.empty() && part != ".")
+                parts.push_back(part);
+            start = slash + 1;
+        }
+        std::string name = !path.empty() && path[0] == '/' ? "/" : "";
+        for (size_t i = 0; i < parts.size(); i++)
+            name += (i > 0 ? "/" : "") + parts[i];
+        return name;
+    }
+
+private:
+    std::shared_ptr<MappedFile> mapping;
+    const ScenePackEntry *entries;
+    uint32_t entryCount;
+    mutable std::mutex invalidatedMutex;
+    std::unordered_set<std::string> invalidated;
+    std::atomic<bool> anyInvalidated;
+
+    ScenePack() : entries(nullptr), entryCount(0), anyInvalidated(false)
+    {
+    }
+};
+
+// one file to go into a pack, see WriteScenePack. sources are the files data was made from, stamped before they
+// were read, the file itself included.
+struct ScenePackFile {
+    std::string name;
+    Pack_Entry_Kind kind;
+    uint64_t contentHash;
+    std::string data;
+    std::vector<SourceStamp> sources;
+};
+
+// writes files as a scene pack (atomically, see WriteFileAtomic). Names are normalized like lookups are.
+// An existing pack with the same contents is left alone, unchanged (if given) tells whether that happened.
+inline bool WriteScenePack(const std::string &path, const std::vector<ScenePackFile> &files, bool *unchanged = nullptr)
+{
+    std::vector<ScenePackEntry> entries(files.size());
+    std::vector<std::string> names(files.size());
+    size_t sourceCount = 0;
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        names[i] = ScenePack::NormalizePath(files[i].name);
+        entries[i].nameHash = HashString(names[i]);
+        entries[i].contentHash = files[i].contentHash;
+        entries[i].kind = files[i].kind;
+        entries[i].sourceCount = files[i].sources.size();
+        entries[i].reserved = 0;
+        sourceCount += files[i].sources.size();
+    }
+    std::vector<size_t> order(files.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return entries[a].nameHash < entries[b].nameHash; });
+
+    auto align = [](std::string &blob) {
+        blob.resize((blob.size() + SCENE_PACK_ALIGNMENT - 1) / SCENE_PACK_ALIGNMENT * SCENE_PACK_ALIGNMENT, '\0');
+        return uint64_t(blob.size());
+    };
+    size_t sourcesStart = sizeof(ScenePackHeader) + files.size() * sizeof(ScenePackEntry);
+    std::string blob(sourcesStart + sourceCount * sizeof(ScenePackSource), '\0');
+    uint32_t sourceIndex = 0;
+    for (size_t i : order)
+    {
+        entries[i].nameOffset = blob.size();
+        entries[i].nameLength = names[i].size();
+        blob.append(names[i]);
+        entries[i].sourceIndex = sourceIndex;
+        for (const SourceStamp &stamp : files[i].sources)
+        {
+            ScenePackSource source;
+            source.size = stamp.size;
+            source.modified = stamp.modified;
+            source.nameOffset = blob.size();
+            source.nameLength = stamp.path.size();
+            blob.append(stamp.path);
+            memcpy(&blob[sourcesStart + sourceIndex * sizeof(ScenePackSource)], &source, sizeof(source));
+            sourceIndex++;
+        }
+    }
+    for (size_t i : order)
+    {
+        entries[i].offset = align(blob);
+        entries[i].size = files[i].data.size();
+        blob.append(files[i].data);
+    }
+
+    ScenePackHeader header;
+    memcpy(header.magic, SCENE_PACK_MAGIC, sizeof(header.magic));
+    header.version = SCENE_PACK_VERSION;
+    header.entryCount = files.size();
+    header.sourceCount = sourceCount;
+    header.reserved = 0;
+    for (size_t slot = 0; slot < order.size(); slot++)
+        memcpy(&blob[sizeof(header) + slot * sizeof(ScenePackEntry)], &entries[order[slot]], sizeof(ScenePackEntry));
+    header.key = HashContent(blob.data() + sizeof(header), blob.size() - sizeof(header));
+    memcpy(&blob[0], &header, sizeof(header));
+
+    bool same;
+    {
+        MappedFile existing(path);
+        same = existing.size() == blob.size() && memcmp(existing.data(), blob.data(), sizeof(header)) == 0;
+    }
+    if (unchanged)
+        *unchanged = same;
+    return same || WriteFileAtomic(path, blob.data(), blob.size());
+}
+#endif
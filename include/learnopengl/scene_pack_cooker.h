@@ -0,0 +1,199 @@
+#ifndef SCENE_PACK_COOKER_H
+#define SCENE_PACK_COOKER_H
+
+#include <learnopengl/hash.h>
+#include <learnopengl/ktx.h>
+#include <learnopengl/mapped_file.h>
+#include <learnopengl/mesh_cache.h>
+#include <learnopengl/model.h>
+#include <learnopengl/scene_pack.h>
+#include <learnopengl/texture_loader.h>
+#include <learnopengl/thread_pool.h>
+
+#include <chrono>
+#include <iostream>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+// the files that go into a pack. Model textures don't need to be listed, they are taken from the materials;
+// textures lists the other ones, with the usage the program loads them with.
+struct ScenePackSources {
+    std::vector<std::string> models;
+    std::vector<std::pair<std::string, Texture_Usage>> textures;
+    std::vector<std::string> shaders;
+};
+
+// what cooking did for one file of a pack
+struct CookedAsset {
+    std::string path;
+    Pack_Entry_Kind kind = PACK_SHADER;
+    bool cooked = false;        // false if the source couldn't be read or converted
+    bool rebuilt = false;       // the cached output was missing or stale
+    double cookMs = 0.0;        // import or conversion time, 0 if the cached output was up to date
+    double loadMs = 0.0;        // time to load the cooked output, what a warm start pays for the file
+    ScenePackFile file;
+};
+
+inline double CookMilliseconds(std::chrono::steady_clock::time_point start)
+{
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+// brings the mesh cache of a model up to date, importing it only if the source or the import settings changed.
+// textures receives the material textures with the usage Model loads them with.
+inline void CookModel(CookedAsset &asset, std::vector<std::pair<std::string, Texture_Usage>> &textures)
+{
+    std::vector<SourceStamp> stamps(1, StampFile(asset.path));
+    MappedFile source(asset.path);
+    if (!source.isOpen())
+        return;
+    if (IsObjFile(asset.path))
+        for (const string &library : ObjMaterialLibraries(asset.path, source.data(), source.size()))
+            stamps.push_back(StampFile(library));
+    uint64_t key = Model::CacheKeyFor(asset.path, source);
+    source.close();
+    string cachePath = CachePathFor(asset.path, ".meshcache");
+
+    auto start = std::chrono::steady_clock::now();
+    MeshCache cache;
+    if (!cache.load(cachePath, key))
+    {
+        ModelData data;
+        if (!Model::Import(asset.path, data))
+            return;
+        asset.cookMs = CookMilliseconds(start);
+        asset.rebuilt = true;
+        start = std::chrono::steady_clock::now();
+        if (!cache.load(cachePath, key))
+            return;
+    }
+    asset.loadMs = CookMilliseconds(start);
+
+    string directory = asset.path.substr(0, asset.path.find_last_of('/'));
+    for (const MeshData &mesh : cache.getMeshes())
+        for (const Texture &texture : mesh.textures)
+            textures.push_back(std::make_pair(directory + '/' + texture.path, Model::UsageFor(texture.type)));
+    asset.file = ScenePackFile{asset.path, PACK_MESHES, key, MeshCache::Serialize(key, cache.getMeshes()), stamps};
+    asset.cooked = true;
+}
+
+// brings the .ktx of a texture up to date, converting it only if the image or the conversion settings changed
+inline void CookTexture(CookedAsset &asset, Texture_Usage usage, bool s3tc, ThreadPool *encoders)
+{
+    uint64_t contentHash;
+    std::vector<SourceStamp> stamps(1, StampFile(asset.path));
+    {
+        MappedFile source(asset.path);
+        if (!source.isOpen())
+            return;
+        contentHash = HashContent(source.data(), source.size());
+    }
+    std::string ktxPath = CachePathFor(asset.path, ".ktx");
+    std::string cacheKey = TextureCacheKey(contentHash, usage, s3tc);
+
+    auto start = std::chrono::steady_clock::now();
+    TextureLevels texture;
+    if (!ReadKtx(ktxPath, texture) || KtxValue(texture, "cg.source") != cacheKey)
+    {
+        if (!ConvertTexture(asset.path, ktxPath, cacheKey, usage, s3tc, texture, encoders))
+            return;
+        asset.cookMs = CookMilliseconds(start);
+        asset.rebuilt = true;
+        start = std::chrono::steady_clock::now();
+        if (!ReadKtx(ktxPath, texture))
+            return;
+    }
+    asset.loadMs = CookMilliseconds(start);
+    asset.file = ScenePackFile{asset.path, PACK_TEXTURE, contentHash, SerializeKtx(texture), stamps};
+    asset.cooked = true;
+}
+
+inline void CookShader(CookedAsset &asset)
+{
+    auto start = std::chrono::steady_clock::now();
+    std::vector<SourceStamp> stamps(1, StampFile(asset.path));
+    MappedFile source(asset.path);
+    if (!source.isOpen())
+        return;
+    asset.file = ScenePackFile{asset.path, PACK_SHADER, HashContent(source.data(), source.size()),
+                               std::string(reinterpret_cast<const char*>(source.data()), source.size()), stamps};
+    asset.loadMs = CookMilliseconds(start);
+    asset.cooked = true;
+}
+
+// cooks every source (models and textures in parallel on pool, block compression on encoders) and writes the
+// results into the pack at packPath. Outputs are cached on disk next to the runtime caches, so only files whose
+// source or settings changed are rebuilt, and the pack itself only if its contents changed. Textures are converted
+// for s3tc unless told otherwise; the viewer converts them again if the driver turns out not to have it.
+// assets receives one entry per file: models, then textures (material ones first), then shaders.
+// Returns false if the pack couldn't be written.
+inline bool CookScenePack(const std::string &packPath, const ScenePackSources &sources, bool s3tc,
+                          ThreadPool &pool, ThreadPool &encoders, std::vector<CookedAsset> &assets)
+{
+    // the loaders would read from a mounted pack instead of the sources
+    ScenePack::Instance().unmount();
+    assets.clear();
+
+    // models first, their materials name the rest of the textures
+    std::vector<CookedAsset> models(sources.models.size());
+    std::vector<std::vector<std::pair<std::string, Texture_Usage>>> materialTextures(sources.models.size());
+    ParallelFor(&pool, models.size(), [&](size_t i) {
+        models[i].path = sources.models[i];
+        models[i].kind = PACK_MESHES;
+        CookModel(models[i], materialTextures[i]);
+    });
+
+    // every distinct image once. The materials decide the usage of the images they name, that is what Model loads
+    // them with; listed images only add the ones no material refers to.
+    std::vector<std::pair<std::string, Texture_Usage>> textureSources;
+    std::set<std::string> seen;
+    auto addTexture = [&](const std::pair<std::string, Texture_Usage> &texture) {
+        if (seen.insert(ScenePack::NormalizePath(texture.first)).second)
+            textureSources.push_back(texture);
+    };
+    for (const auto &modelTextures : materialTextures)
+        for (const auto &texture : modelTextures)
+            addTexture(texture);
+    for (const auto &texture : sources.textures)
+        addTexture(texture);
+
+    std::vector<CookedAsset> textures(textureSources.size());
+    ParallelFor(&pool, textures.size(), [&](size_t i) {
+        textures[i].path = textureSources[i].first;
+        textures[i].kind = PACK_TEXTURE;
+        CookTexture(textures[i], textureSources[i].second, s3tc, &encoders);
+    });
+
+    std::vector<CookedAsset> shaders(sources.shaders.size());
+    for (size_t i = 0; i < shaders.size(); i++)
+    {
+        shaders[i].path = sources.shaders[i];
+        CookShader(shaders[i]);
+    }
+
+    std::vector<ScenePackFile> files;
+    for (std::vector<CookedAsset> *group : {&models, &textures, &shaders})
+    {
+        for (CookedAsset &asset : *group)
+        {
+            if (asset.cooked)
+                files.push_back(std::move(asset.file));
+            asset.file = ScenePackFile();
+            assets.push_back(std::move(asset));
+        }
+    }
+
+    bool unchanged = false;
+    if (!WriteScenePack(packPath, files, &unchanged))
+    {
+        std::cout << "ERROR::SCENE_PACK:: could not write " << packPath << std::endl;
+        return false;
+    }
+    std::cout << "ScenePack: " << packPath << ": " << files.size() << " files, "
+              << (unchanged ? "up to date" : "written") << std::endl;
+    return true;
+}
+#endif
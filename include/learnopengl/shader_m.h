@@ -4,146 +4,500 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <common.h>
+#include <learnopengl/gl_extensions.h>
+#include <learnopengl/program_cache.h>
+#include <learnopengl/scene_pack.h>
+#include <learnopengl/uniform.h>
+// a linked (or still linking) GL program. Shaders whose sources come out of the preprocessor the same share one,
+// and with it one set of uniform values (see Shader::Programs).
+struct ShaderProgram
+{
+    unsigned int ID = 0;
+    uint64_t key = 0;               // hash of the preprocessed sources
+    // shaders of a program Shader::reload started, until the link finished
+    unsigned int vertex = 0;
+    unsigned int fragment = 0;
+    bool linking = false;
+    bool polled = false;
+    bool failed = false;
+    bool fresh = false;             // built by a reload, still needs the uniform values of the program it replaces
+};
+
 class Shader
 {
 public:
     unsigned int ID;
-    // constructor generates the shader on the fly
+    // constructor generates the shader on the fly. defines are added to both sources after #version, e.g.
+    // "NR_POINT_LIGHTS 4"; #include "file" lines are replaced by the file, relative to the one including it.
     // ------------------------------------------------------------------------
-    Shader(const char* vertexPath, const char* fragmentPath)
+    Shader(const char* vertexPath, const char* fragmentPath, const std::vector<std::string> &defines = std::vector<std::string>())
+        : vertexPath(vertexPath), fragmentPath(fragmentPath), defines(defines)
     {
-        std::string vertexPathString(vertexPath);
-        std::string fragmentPathString(fragmentPath);
-        vertexPath = vertexPathString.c_str();
-        fragmentPath= fragmentPathString.c_str();
-
-        // 1. retrieve the vertex/fragment source code from filePath
+        // 1. retrieve the vertex/fragment source code with their includes, from the mounted scene pack or from filePath
         std::string vertexCode;
         std::string fragmentCode;
-        std::ifstream vShaderFile;
-        std::ifstream fShaderFile;
-        // ensure ifstream objects can throw exceptions:
-        vShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        fShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        try 
-        {
-            // open files
-            vShaderFile.open(vertexPath);
-            fShaderFile.open(fragmentPath);
-            std::stringstream vShaderStream, fShaderStream;
-            // read file's buffer contents into streams
-            vShaderStream << vShaderFile.rdbuf();
-            fShaderStream << fShaderFile.rdbuf();		
-            // close file handlers
-            vShaderFile.close();
-            fShaderFile.close();
-            // convert stream into string
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();			
+        preprocess(vertexCode, fragmentCode);
+        const char* vShaderCode = vertexCode.c_str();
+        const char* fShaderCode = fragmentCode.c_str();
+        GLint vShaderLength = vertexCode.size();
+        GLint fShaderLength = fragmentCode.size();
+        // 2. shaders that come out the same as an earlier one use its program
+        uint64_t key = keyFor(vertexCode, fragmentCode);
+        program = findProgram(key);
+        if (program)
+        {
+            ID = program->ID;
+            uniforms.build(ID);
+            return;
         }
-        catch (std::ifstream::failure& e)
+        program = addProgram(key);
+        // 3. a warm start takes the linked program from the program binary cache
+        ID = program->ID = glCreateProgram();
+        std::string cachePath = ProgramCache::PathFor(this->vertexPath, this->fragmentPath, this->defines);
+        uint64_t cacheKey = ProgramCache::KeyFor(vShaderCode, vShaderLength, fShaderCode, fShaderLength);
+        if (ProgramCache::Instance().load(ID, cachePath, cacheKey))
         {
-            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
+            uniforms.build(ID);
+            return;
         }
-        const char* vShaderCode = vertexCode.c_str();
-        const char * fShaderCode = fragmentCode.c_str();
-        // 2. compile shaders
+        auto compileStart = std::chrono::steady_clock::now();
+        // 4. compile shaders
         unsigned int vertex, fragment;
         // vertex shader
         vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderCode, NULL);
+        glShaderSource(vertex, 1, &vShaderCode, &vShaderLength);
         glCompileShader(vertex);
         checkCompileErrors(vertex, "VERTEX");
         // fragment Shader
         fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderCode, NULL);
+        glShaderSource(fragment, 1, &fShaderCode, &fShaderLength);
         glCompileShader(fragment);
         checkCompileErrors(fragment, "FRAGMENT");
         // shader Program
-        ID = glCreateProgram();
         glAttachShader(ID, vertex);
         glAttachShader(ID, fragment);
+        ProgramCache::Instance().prepare(ID);
         glLinkProgram(ID);
-        checkCompileErrors(ID, "PROGRAM");
+        if (checkCompileErrors(ID, "PROGRAM"))
+            ProgramCache::Instance().store(ID, cachePath, cacheKey, ProgramCache::milliseconds(compileStart));
+        uniforms.build(ID);
         // delete the shaders as they're linked into our program now and no longer necessery
         glDeleteShader(vertex);
         glDeleteShader(fragment);
 
     }
+    // starts compiling the shader again if path is one of its source files or their includes, after it changed on
+    // disk (see FileWatcher). Only compile and link are started here, ID stays the program in use until update()
+    // finds the new one linked. Shaders that come out the same again share the new program, it is only built once.
+    // GL thread only.
+    // ------------------------------------------------------------------------
+    bool reload(const std::string &path)
+    {
+        if (std::find(files.begin(), files.end(), ScenePack::NormalizePath(path)) == files.end())
+            return false;
+        ParallelShaderCompile();
+        std::string vertexCode;
+        std::string fragmentCode;
+        preprocess(vertexCode, fragmentCode);
+        uint64_t key = keyFor(vertexCode, fragmentCode);
+        if (key == program->key)
+        {
+            // saved without changes, or changed back before the reload finished
+            releaseProgram(pending);
+            return true;
+        }
+        if (pending && pending->key == key)
+            return true;
+        releaseProgram(pending);
+        pending = findProgram(key);
+        if (pending)
+            return true;
+
+        pending = addProgram(key);
+        const char* vShaderCode = vertexCode.c_str();
+        const char* fShaderCode = fragmentCode.c_str();
+        GLint vShaderLength = vertexCode.size();
+        GLint fShaderLength = fragmentCode.size();
+        // no status queries, they would wait for the compiler
+        pending->vertex = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(pending->vertex, 1, &vShaderCode, &vShaderLength);
+        glCompileShader(pending->vertex);
+        pending->fragment = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(pending->fragment, 1, &fShaderCode, &fShaderLength);
+        glCompileShader(pending->fragment);
+        pending->ID = glCreateProgram();
+        glAttachShader(pending->ID, pending->vertex);
+        glAttachShader(pending->ID, pending->fragment);
+        glLinkProgram(pending->ID);
+        pending->linking = true;
+        pending->fresh = true;
+        return true;
+    }
+    // GL thread, once per frame: swaps in the program reload() started once it has linked, with the uniform values
+    // of the old one. A program that fails keeps the old one in use. With KHR_parallel_shader_compile the link
+    // status is only asked for when the driver reports completion; without it not before the next call, the driver
+    // has had a frame to finish by then.
+    // ------------------------------------------------------------------------
+    void update()
+    {
+        if (!pending || !finishLinking(*pending))
+            return;
+        if (pending->failed)
+        {
+            std::cout << "ERROR::SHADER:: reloading " << vertexPath << ", " << fragmentPath << " failed, keeping the old program" << std::endl;
+            releaseProgram(pending);
+            return;
+        }
+        if (pending->fresh)
+        {
+            copyUniforms(program->ID, pending->ID);
+            pending->fresh = false;
+        }
+        releaseProgram(program);
+        program = pending;
+        pending.reset();
+        ID = program->ID;
+        uniforms.build(ID);
+        std::cout << "Shader: " << vertexPath << ", " << fragmentPath << ": reloaded" << std::endl;
+    }
     // activate the shader
     // ------------------------------------------------------------------------
     void use() const
     { 
         glUseProgram(ID); 
     }
-    // utility uniform functions
+    // utility uniform functions, the name is looked up in the table of the program's uniforms
     // ------------------------------------------------------------------------
-    void setBool(const std::string &name, bool value) const
+    void setBool(UniformName name, bool value) const
     {         
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
+        SetUniform(uniforms.location(name), value);
     }
     // ------------------------------------------------------------------------
-    void setInt(const std::string &name, int value) const
+    void setInt(UniformName name, int value) const
     { 
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
+        SetUniform(uniforms.location(name), value);
     }
     // ------------------------------------------------------------------------
-    void setFloat(const std::string &name, float value) const
+    void setFloat(UniformName name, float value) const
     { 
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
+        SetUniform(uniforms.location(name), value);
     }
     // ------------------------------------------------------------------------
-    void setVec2(const std::string &name, const glm::vec2 &value) const
+    void setVec2(UniformName name, const glm::vec2 &value) const
     { 
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        SetUniform(uniforms.location(name), value);
     }
-    void setVec2(const std::string &name, float x, float y) const
+    void setVec2(UniformName name, float x, float y) const
     { 
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y); 
+        glUniform2f(uniforms.location(name), x, y);
     }
     // ------------------------------------------------------------------------
-    void setVec3(const std::string &name, const glm::vec3 &value) const
+    void setVec3(UniformName name, const glm::vec3 &value) const
     { 
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        SetUniform(uniforms.location(name), value);
     }
-    void setVec3(const std::string &name, float x, float y, float z) const
+    void setVec3(UniformName name, float x, float y, float z) const
     { 
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z); 
+        glUniform3f(uniforms.location(name), x, y, z);
     }
     // ------------------------------------------------------------------------
-    void setVec4(const std::string &name, const glm::vec4 &value) const
+    void setVec4(UniformName name, const glm::vec4 &value) const
     { 
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        SetUniform(uniforms.location(name), value);
     }
-    void setVec4(const std::string &name, float x, float y, float z, float w) const
+    void setVec4(UniformName name, float x, float y, float z, float w) const
     { 
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w); 
+        glUniform4f(uniforms.location(name), x, y, z, w);
+    }
+    // ------------------------------------------------------------------------
+    void setMat2(UniformName name, const glm::mat2 &mat) const
+    {
+        SetUniform(uniforms.location(name), mat);
     }
     // ------------------------------------------------------------------------
-    void setMat2(const std::string &name, const glm::mat2 &mat) const
+    void setMat3(UniformName name, const glm::mat3 &mat) const
     {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        SetUniform(uniforms.location(name), mat);
     }
     // ------------------------------------------------------------------------
-    void setMat3(const std::string &name, const glm::mat3 &mat) const
+    void setMat4(UniformName name, const glm::mat4 &mat) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        SetUniform(uniforms.location(name), mat);
     }
+    // handle of a uniform for the frame loop, set without any lookup (see uniform.h). Stays valid as long as the
+    // shader, across hot reloads.
     // ------------------------------------------------------------------------
-    void setMat4(const std::string &name, const glm::mat4 &mat) const
+    template <typename T>
+    Uniform<T> uniform(UniformName name)
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        return uniforms.handle<T>(name);
+    }
+    // the active uniforms of the program, for code that keeps locations of its own (see Mesh::Draw)
+    // ------------------------------------------------------------------------
+    const UniformTable &uniformTable() const
+    {
+        return uniforms;
     }
 
 private:
-    // utility function for checking shader compilation/linking errors.
+    std::string vertexPath;
+    std::string fragmentPath;
+    std::vector<std::string> defines;
+    UniformTable uniforms;
+    // normalized paths of the sources and everything they include, for reload()
+    std::vector<std::string> files;
+    std::shared_ptr<ShaderProgram> program;
+    // program being built by reload()
+    std::shared_ptr<ShaderProgram> pending;
+
+    // all programs by the hash of their preprocessed sources. Only the shaders own them, so a program no shader
+    // uses anymore is gone from here as well. GL thread only.
+    static std::unordered_map<uint64_t, std::weak_ptr<ShaderProgram>> &Programs()
+    {
+        static std::unordered_map<uint64_t, std::weak_ptr<ShaderProgram>> programs;
+        return programs;
+    }
+    static std::shared_ptr<ShaderProgram> findProgram(uint64_t key)
+    {
+        auto found = Programs().find(key);
+        return found != Programs().end() ? found->second.lock() : nullptr;
+    }
+    static std::shared_ptr<ShaderProgram> addProgram(uint64_t key)
+    {
+        std::shared_ptr<ShaderProgram> added = std::make_shared<ShaderProgram>();
+        added->key = key;
+        Programs()[key] = added;
+        return added;
+    }
+    // lets go of program, deleting it if no other shader uses it
+    static void releaseProgram(std::shared_ptr<ShaderProgram> &program)
+    {
+        if (program && program.use_count() == 1)
+        {
+            if (program->ID != 0)
+                glDeleteProgram(program->ID);
+            if (program->vertex != 0)
+                glDeleteShader(program->vertex);
+            if (program->fragment != 0)
+                glDeleteShader(program->fragment);
+            Programs().erase(program->key);
+        }
+        program.reset();
+    }
+    // true once the link reload() started is done (failed tells how), for every shader sharing the program
+    static bool finishLinking(ShaderProgram &program)
+    {
+        if (!program.linking)
+            return true;
+        if (ParallelShaderCompile())
+        {
+            GLint completed = GL_FALSE;
+            glGetProgramiv(program.ID, GL_COMPLETION_STATUS_KHR, &completed);
+            if (!completed)
+                return false;
+        }
+        else if (!program.polled)
+        {
+            program.polled = true;
+            return false;
+        }
+        program.linking = false;
+        program.failed = !checkCompileErrors(program.vertex, "VERTEX") | !checkCompileErrors(program.fragment, "FRAGMENT")
+                         | !checkCompileErrors(program.ID, "PROGRAM");
+        glDeleteShader(program.vertex);
+        glDeleteShader(program.fragment);
+        program.vertex = program.fragment = 0;
+        return true;
+    }
+    static uint64_t keyFor(const std::string &vertexCode, const std::string &fragmentCode)
+    {
+        return HashString(fragmentCode, HashValue(vertexCode.size(), HashString(vertexCode)));
+    }
+    // sets the uniforms of program to to the values they have in program from, matched by name. Most uniforms are
+    // set every frame anyway, this keeps the ones set once at startup (sampler units, material constants).
+    // ------------------------------------------------------------------------
+    static void copyUniforms(unsigned int from, unsigned int to)
+    {
+        GLint current = 0;
+        glGetIntegerv(GL_CURRENT_PROGRAM, &current);
+        glUseProgram(to);
+        GLint count = 0;
+        glGetProgramiv(to, GL_ACTIVE_UNIFORMS, &count);
+        for (GLint i = 0; i < count; i++)
+        {
+            GLchar name[256];
+            GLsizei nameLength = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(to, i, sizeof(name), &nameLength, &size, &type, name);
+            std::string base(name, nameLength);
+            // arrays of basic types come as one uniform named "name[0]", their elements are copied one by one
+            if (size > 1 && base.size() > 3 && base.compare(base.size() - 3, 3, "[0]") == 0)
+                base.resize(base.size() - 3);
+            for (GLint element = 0; element < size; element++)
+            {
+                std::string elementName = size > 1 ? base + "[" + std::to_string(element) + "]" : base;
+                GLint source = glGetUniformLocation(from, elementName.c_str());
+                GLint target = glGetUniformLocation(to, elementName.c_str());
+                if (source >= 0 && target >= 0)
+                    copyUniform(from, source, target, type);
+            }
+        }
+        glUseProgram(current);
+    }
+    // copies one uniform into the bound program
+    static void copyUniform(unsigned int from, GLint source, GLint target, GLenum type)
+    {
+        GLfloat f[16];
+        GLint i[4];
+        switch (type)
+        {
+            case GL_FLOAT:          glGetUniformfv(from, source, f); glUniform1fv(target, 1, f); break;
+            case GL_FLOAT_VEC2:     glGetUniformfv(from, source, f); glUniform2fv(target, 1, f); break;
+            case GL_FLOAT_VEC3:     glGetUniformfv(from, source, f); glUniform3fv(target, 1, f); break;
+            case GL_FLOAT_VEC4:     glGetUniformfv(from, source, f); glUniform4fv(target, 1, f); break;
+            case GL_FLOAT_MAT2:     glGetUniformfv(from, source, f); glUniformMatrix2fv(target, 1, GL_FALSE, f); break;
+            case GL_FLOAT_MAT3:     glGetUniformfv(from, source, f); glUniformMatrix3fv(target, 1, GL_FALSE, f); break;
+            case GL_FLOAT_MAT4:     glGetUniformfv(from, source, f); glUniformMatrix4fv(target, 1, GL_FALSE, f); break;
+            case GL_INT_VEC2:
+            case GL_BOOL_VEC2:      glGetUniformiv(from, source, i); glUniform2iv(target, 1, i); break;
+            case GL_INT_VEC3:
+            case GL_BOOL_VEC3:      glGetUniformiv(from, source, i); glUniform3iv(target, 1, i); break;
+            case GL_INT_VEC4:
+            case GL_BOOL_VEC4:      glGetUniformiv(from, source, i); glUniform4iv(target, 1, i); break;
+            case GL_INT:
+            case GL_BOOL:
+            case GL_SAMPLER_2D:
+            case GL_SAMPLER_3D:
+            case GL_SAMPLER_CUBE:
+            case GL_SAMPLER_2D_SHADOW:
+            case GL_SAMPLER_2D_ARRAY:   glGetUniformiv(from, source, i); glUniform1iv(target, 1, i); break;
+            default: break;     // unsigned and the remaining sampler types aren't used by our shaders
+        }
+    }
+    // reads both sources through the preprocessor, collecting the files they are made of
+    // ------------------------------------------------------------------------
+    void preprocess(std::string &vertexCode, std::string &fragmentCode)
+    {
+        files.clear();
+        std::vector<std::string> included;
+        appendSource(vertexPath, vertexCode, included);
+        included.clear();
+        appendSource(fragmentPath, fragmentCode, included);
+    }
+    // appends the source at path to output with each #include "file" line replaced by that file (relative to path,
+    // every file at most once per shader) and the defines after #version. #line directives keep the line numbers
+    // of compile errors right, their source string number is the position of the file in included.
+    // ------------------------------------------------------------------------
+    void appendSource(const std::string &path, std::string &output, std::vector<std::string> &included)
+    {
+        std::string name = ScenePack::NormalizePath(path);
+        if (std::find(included.begin(), included.end(), name) != included.end())
+            return;
+        size_t index = included.size();
+        included.push_back(name);
+        if (std::find(files.begin(), files.end(), name) == files.end())
+            files.push_back(name);
+        std::string storage;
+        const char* code;
+        GLint length;
+        if (!readSource(path.c_str(), storage, code, length))
+            return;
+        if (index > 0)
+            output += "#line 1 " + std::to_string(index) + "\n";
+
+        std::string directory = path.substr(0, path.find_last_of("/\\") + 1);
+        const char* end = code + length;
+        int lineNumber = 0;
+        for (const char* line = code; line < end; )
+        {
+            const char* next = std::find(line, end, '\n');
+            lineNumber++;
+            const char* directive = line;
+            while (directive < next && (*directive == ' ' || *directive == '\t'))
+                directive++;
+            if (index == 0 && !defines.empty() && startsWith(directive, next, "#version"))
+            {
+                output.append(line, next);
+                output += '\n';
+                for (const std::string &define : defines)
+                    output += "#define " + define + "\n";
+                output += "#line " + std::to_string(lineNumber + 1) + " 0\n";
+            }
+            else if (startsWith(directive, next, "#include"))
+            {
+                const char* open = std::find(directive, next, '"');
+                const char* close = open < next ? std::find(open + 1, next, '"') : next;
+                if (close < next)
+                    appendSource(directory + std::string(open + 1, close), output, included);
+                else
+                    std::cout << "ERROR::SHADER::BAD_INCLUDE " << path << ":" << lineNumber << std::endl;
+                output += "#line " + std::to_string(lineNumber + 1) + " " + std::to_string(index) + "\n";
+            }
+            else
+            {
+                output.append(line, next);
+                output += '\n';
+            }
+            line = next + 1;
+        }
+    }
+    static bool startsWith(const char* begin, const char* end, const char* prefix)
+    {
+        size_t length = strlen(prefix);
+        return size_t(end - begin) >= length && memcmp(begin, prefix, length) == 0;
+    }
+    // points code at the source of the shader at path: inside the scene pack mapping if the pack has it (no copy),
+    // otherwise read from the file into storage. False if there is no such file.
+    // ------------------------------------------------------------------------
+    static bool readSource(const char* path, std::string &storage, const char* &code, GLint &length)
+    {
+        ScenePackSpan packed;
+        if (ScenePack::Instance().find(path, PACK_SHADER, packed))
+        {
+            code = reinterpret_cast<const char*>(packed.data);
+            length = packed.size;
+            return true;
+        }
+        std::ifstream shaderFile;
+        // ensure ifstream objects can throw exceptions:
+        shaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
+        bool read = true;
+        try
+        {
+            // open file
+            shaderFile.open(path);
+            std::stringstream shaderStream;
+            // read file's buffer contents into stream
+            shaderStream << shaderFile.rdbuf();
+            // close file handler
+            shaderFile.close();
+            // convert stream into string
+            storage = shaderStream.str();
+        }
+        catch (std::ifstream::failure& e)
+        {
+            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ " << path << std::endl;
+            read = false;
+        }
+        code = storage.c_str();
+        length = storage.size();
+        return read;
+    }
+    // utility function for checking shader compilation/linking errors, returns true if there are none.
     // ------------------------------------------------------------------------
-    void checkCompileErrors(GLuint shader, std::string type)
+    static bool checkCompileErrors(GLuint shader, std::string type)
     {
         GLint success;
         GLchar infoLog[1024];
@@ -165,6 +519,7 @@ private:
                 std::cout << "ERROR::PROGRAM_LINKING_ERROR of type: " << type << "\n" << infoLog << "\n -- --------------------------------------------------- -- " << std::endl;
             }
         }
+        return success != GL_FALSE;
     }
 };
 #endif
@@ -0,0 +1,405 @@
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <glad/glad.h>
+#include <stb_image.h>
+
+#include <learnopengl/block_compression.h>
+#include <learnopengl/gl_extensions.h>
+#include <learnopengl/hash.h>
+#include <learnopengl/ktx.h>
+#include <learnopengl/mapped_file.h>
+#include <learnopengl/scene_pack.h>
+#include <learnopengl/thread_pool.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// decoded image, ready for glTexImage2D. Decoding is thread-safe, the upload has to happen on the GL thread.
+struct ImageData {
+    int width = 0;
+    int height = 0;
+    int nrComponents = 0;
+    std::shared_ptr<unsigned char> pixels;
+};
+
+// decodes an image file, safe to call from worker threads
+inline ImageData LoadImageData(const std::string &filename)
+{
+    ImageData image;
+    unsigned char *data = stbi_load(filename.c_str(), &image.width, &image.height, &image.nrComponents, 0);
+    if (data)
+        image.pixels = std::shared_ptr<unsigned char>(data, stbi_image_free);
+    return image;
+}
+
+// bump whenever the way textures are converted changes, existing .ktx files are then rebuilt
+const uint32_t TEXTURE_CACHE_VERSION = 2;
+
+// identifies the conversion of one source image, stored in the .ktx so stale files are detected.
+// s3tc is part of it since the same image converts differently without BC1/BC3 support.
+inline std::string TextureCacheKey(uint64_t contentHash, Texture_Usage usage, bool s3tc)
+{
+    uint64_t key = HashValue(TEXTURE_CACHE_VERSION, contentHash);
+    key = HashValue((uint32_t)usage, key);
+    return HashToString(HashValue((uint32_t)s3tc, key));
+}
+
+// converter from a source image (anything stb_image reads) to a .ktx with the complete mip chain, block compressed
+// where ChooseBlockFormat finds a format for it. Compression is spread over encoders if given.
+// Returns the converted levels, which stay valid even if writing the file fails.
+inline bool ConvertTexture(const std::string &sourcePath, const std::string &ktxPath, const std::string &cacheKey,
+                           Texture_Usage usage, bool s3tc, TextureLevels &texture, ThreadPool *encoders = nullptr)
+{
+    ImageData image = LoadImageData(sourcePath);
+    if (!image.pixels)
+        return false;
+    texture = GenerateMipChain(image.pixels.get(), image.width, image.height, image.nrComponents, usage);
+    GLenum blockFormat = ChooseBlockFormat(texture, usage, s3tc);
+    if (blockFormat != 0)
+        texture = CompressTextureLevels(texture, blockFormat, encoders);
+    texture.keyValues.push_back(std::make_pair(std::string("cg.source"), cacheKey));
+    WriteKtx(ktxPath, texture);
+    return true;
+}
+
+// returns the mip chain of a source image: straight from the mounted scene pack, mapped from its up to date .ktx in
+// the cache directory, or converted (and written to the cache for the next run). contentHash 0 means the caller
+// didn't hash the source yet.
+inline bool LoadTextureLevels(const std::string &sourcePath, Texture_Usage usage, uint64_t contentHash, bool s3tc,
+                              TextureLevels &texture, ThreadPool *encoders = nullptr)
+{
+    // the pack holds one conversion per image, if it was cooked for another usage or without s3tc the image goes
+    // the usual way
+    ScenePackSpan packed;
+    if (ScenePack::Instance().find(sourcePath, PACK_TEXTURE, packed))
+    {
+        if (ParseKtx(ScenePack::Instance().file(), packed.data, packed.size, texture)
+            && KtxValue(texture, "cg.source") == TextureCacheKey(packed.contentHash, usage, s3tc))
+            return true;
+        if (contentHash == 0)
+            contentHash = packed.contentHash;
+    }
+    if (contentHash == 0)
+    {
+        MappedFile source(sourcePath);
+        if (!source.isOpen())
+            return false;
+        contentHash = HashContent(source.data(), source.size());
+    }
+    std::string ktxPath = CachePathFor(sourcePath, ".ktx");
+    std::string cacheKey = TextureCacheKey(contentHash, usage, s3tc);
+    if (ReadKtx(ktxPath, texture) && KtxValue(texture, "cg.source") == cacheKey)
+        return true;
+    return ConvertTexture(sourcePath, ktxPath, cacheKey, usage, s3tc, texture, encoders);
+}
+
+// how many loaded textures may wait for upload at once, decode workers block when the queue is full
+const unsigned int TEXTURE_UPLOAD_QUEUE_CAPACITY = 4;
+// default time the GL thread spends on texture uploads per frame
+const double TEXTURE_UPLOAD_BUDGET_MS = 4.0;
+// levels up to this size are uploaded together as soon as a texture is loaded, the larger ones one per step
+const unsigned int TEXTURE_STREAM_TAIL_SIZE = 64;
+
+// what update() has uploaded of a texture so far, for instrumentation
+struct TextureResidency {
+    int residentLevel = -1;         // finest level uploaded (0 is full resolution), -1 while the placeholder is bound
+    unsigned int levelCount = 0;
+    unsigned int width = 0;         // size of the resident level
+    unsigned int height = 0;
+    size_t residentBytes = 0;       // GPU memory of the uploaded levels
+};
+
+// Asynchronous texture loading. request() hands out a texture name immediately with a 1x1 grey placeholder
+// bound to it; worker threads load the mip chain (see LoadTextureLevels) and push it into a bounded upload queue,
+// which the GL thread drains in update() once per frame within a time budget. The name never changes, so callers
+// keep using it as usual.
+//
+// Textures stream in from their smallest levels: update() first uploads the mip tail (TEXTURE_STREAM_TAIL_SIZE and
+// below) so the placeholder disappears right away, then on later calls adds one finer level at a time and lowers
+// GL_TEXTURE_BASE_LEVEL to it, until level 0 is resident. A 4K map never costs one frame the full upload.
+class TextureLoader
+{
+public:
+    static TextureLoader &Instance()
+    {
+        static TextureLoader instance;
+        return instance;
+    }
+
+    TextureLoader(const TextureLoader &) = delete;
+    TextureLoader &operator=(const TextureLoader &) = delete;
+
+    ~TextureLoader()
+    {
+        // unblock workers waiting for room in the queue, their results are dropped
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            shuttingDown = true;
+        }
+        queueSpace.notify_all();
+    }
+
+    // GL thread only: creates the texture with its placeholder and schedules the load.
+    // contentHash is the HashContent of the file if the caller already has it, 0 otherwise.
+    unsigned int request(const std::string &filename, Texture_Usage usage = TEXTURE_COLOR, uint64_t contentHash = 0)
+    {
+        if (!extensionsChecked)
+        {
+            // without s3tc color maps stay uncompressed, see ChooseBlockFormat
+            s3tc = HasExtension("GL_EXT_texture_compression_s3tc");
+            extensionsChecked = true;
+        }
+
+        unsigned int textureID;
+        glGenTextures(1, &textureID);
+        static const unsigned char placeholder[4] = {128, 128, 128, 255};
+        glBindTexture(GL_TEXTURE_2D, textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        residencies[textureID] = TextureResidency();
+        load(textureID, filename, usage, contentHash);
+        return textureID;
+    }
+
+    // GL thread only: loads filename again into textureID, after the file changed on disk. The old image stays bound
+    // until update() has the new one, which then replaces it from the mip tail up like a new texture streams in;
+    // the name doesn't change, so whoever uses the texture never notices. Supersedes a load still in flight.
+    void reload(unsigned int textureID, const std::string &filename, Texture_Usage usage, uint64_t contentHash = 0)
+    {
+        load(textureID, filename, usage, contentHash);
+    }
+
+    // GL thread, once per frame: uploads the mip tails of newly loaded textures, then refines the streaming ones
+    // a level at a time, until budgetMs is spent (at least one step per call)
+    void update(double budgetMs = TEXTURE_UPLOAD_BUDGET_MS)
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto budgetSpent = [start, budgetMs]() {
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            return elapsed.count() >= budgetMs;
+        };
+
+        // new textures first, they still show the placeholder
+        for (;;)
+        {
+            PendingUpload upload;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (ready.empty())
+                    break;
+                upload = std::move(ready.front());
+                ready.pop_front();
+                inFlight--;
+            }
+            queueSpace.notify_one();
+
+            if (!isCurrent(upload.textureID, upload.sequence))
+                continue;
+            if (!upload.loaded)
+            {
+                std::cout << "Texture failed to load at path: " << upload.filename << std::endl;
+                finishRequest(upload.textureID, upload.sequence);
+                continue;
+            }
+
+            StreamingTexture texture;
+            texture.textureID = upload.textureID;
+            texture.sequence = upload.sequence;
+            texture.texture = std::move(upload.texture);
+            texture.residentLevel = texture.texture.levels.size() - 1;
+            while (texture.residentLevel > 0)
+            {
+                const TextureLevel &finer = texture.texture.levels[texture.residentLevel - 1];
+                if (std::max(finer.width, finer.height) > TEXTURE_STREAM_TAIL_SIZE)
+                    break;
+                texture.residentLevel--;
+            }
+            UploadTextureLevels(texture.textureID, texture.texture, texture.residentLevel, texture.texture.levels.size() - 1);
+            updateResidency(texture);
+            if (texture.residentLevel > 0)
+                streaming.push_back(std::move(texture));
+            else
+                finishRequest(texture.textureID, texture.sequence);
+
+            if (budgetSpent())
+                return;
+        }
+
+        // then one level per texture in turn, so everything sharpens evenly
+        while (!streaming.empty())
+        {
+            if (nextStreaming >= streaming.size())
+                nextStreaming = 0;
+            StreamingTexture &texture = streaming[nextStreaming];
+            if (isCurrent(texture.textureID, texture.sequence))
+            {
+                texture.residentLevel--;
+                UploadTextureLevels(texture.textureID, texture.texture, texture.residentLevel, texture.residentLevel);
+                updateResidency(texture);
+            }
+            else
+                texture.residentLevel = 0;  // cancelled, drop it
+
+            if (texture.residentLevel == 0)
+            {
+                finishRequest(texture.textureID, texture.sequence);
+                streaming.erase(streaming.begin() + nextStreaming);
+            }
+            else
+                nextStreaming++;
+
+            if (budgetSpent())
+                return;
+        }
+    }
+
+    // GL thread: blocks until every requested texture has been uploaded, for code that can't live with placeholders
+    void finish()
+    {
+        while (pending() > 0)
+        {
+            update(1e9);
+            std::unique_lock<std::mutex> lock(mutex);
+            if (ready.empty() && inFlight > 0)
+                queueFilled.wait_for(lock, std::chrono::milliseconds(1));
+        }
+    }
+
+    // GL thread: drops a pending request, used before deleting a texture that may still be loading or streaming
+    void cancel(unsigned int textureID)
+    {
+        finishRequest(textureID);
+        residencies.erase(textureID);
+    }
+
+    // GL thread: number of textures requested but not fully resident yet
+    unsigned int pending()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return inFlight + streaming.size();
+    }
+
+    // GL thread: how much of a requested texture has been uploaded, levelCount 0 for unknown names
+    TextureResidency residency(unsigned int textureID) const
+    {
+        auto it = residencies.find(textureID);
+        return it == residencies.end() ? TextureResidency() : it->second;
+    }
+
+private:
+    struct PendingUpload {
+        unsigned int textureID = 0;
+        unsigned long sequence = 0;
+        std::string filename;
+        bool loaded = false;
+        TextureLevels texture;
+    };
+
+    // a texture that has its mip tail uploaded and gets the finer levels over the next updates
+    struct StreamingTexture {
+        unsigned int textureID = 0;
+        unsigned long sequence = 0;
+        TextureLevels texture;
+        size_t residentLevel = 0;
+    };
+
+    std::mutex mutex;
+    std::condition_variable queueSpace;
+    std::condition_variable queueFilled;
+    std::deque<PendingUpload> ready;
+    std::map<unsigned int, unsigned long> activeRequests;  // texture name -> sequence number of its current request
+    unsigned long lastSequence;
+    unsigned int inFlight;
+    bool shuttingDown;
+    // GL thread only
+    std::vector<StreamingTexture> streaming;
+    size_t nextStreaming;
+    std::map<unsigned int, TextureResidency> residencies;
+    bool extensionsChecked;
+    bool s3tc;
+    // block compression of the textures the workers convert, has to outlive the workers waiting on it
+    ThreadPool encoders;
+    // declared last: destroyed (and joined) first, while the members above are still alive
+    ThreadPool workers;
+
+    TextureLoader() : lastSequence(0), inFlight(0), shuttingDown(false), nextStreaming(0), extensionsChecked(false), s3tc(false)
+    {
+    }
+
+    // schedules loading filename into textureID, any earlier request for the name stops being current
+    void load(unsigned int textureID, const std::string &filename, Texture_Usage usage, uint64_t contentHash)
+    {
+        unsigned long sequence;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            inFlight++;
+            sequence = ++lastSequence;
+            activeRequests[textureID] = sequence;
+        }
+        bool s3tc = this->s3tc;
+        workers.enqueue([this, textureID, sequence, filename, usage, contentHash, s3tc]() {
+            PendingUpload upload;
+            upload.textureID = textureID;
+            upload.sequence = sequence;
+            upload.filename = filename;
+            upload.loaded = LoadTextureLevels(filename, usage, contentHash, s3tc, upload.texture, &encoders);
+
+            std::unique_lock<std::mutex> lock(mutex);
+            queueSpace.wait(lock, [this]() { return shuttingDown || ready.size() < TEXTURE_UPLOAD_QUEUE_CAPACITY; });
+            if (shuttingDown)
+                return;
+            ready.push_back(std::move(upload));
+            queueFilled.notify_one();
+        });
+    }
+
+    // false for a cancelled request, or one whose texture name has been deleted and handed out again since
+    bool isCurrent(unsigned int textureID, unsigned long sequence)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto active = activeRequests.find(textureID);
+        return active != activeRequests.end() && active->second == sequence;
+    }
+
+    void finishRequest(unsigned int textureID)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        activeRequests.erase(textureID);
+    }
+
+    // ends the request with that sequence number only, a reload may have replaced it already
+    void finishRequest(unsigned int textureID, unsigned long sequence)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto active = activeRequests.find(textureID);
+        if (active != activeRequests.end() && active->second == sequence)
+            activeRequests.erase(active);
+    }
+
+    void updateResidency(const StreamingTexture &texture)
+    {
+        TextureResidency &residency = residencies[texture.textureID];
+        const TextureLevel &level = texture.texture.levels[texture.residentLevel];
+        residency.residentLevel = texture.residentLevel;
+        residency.levelCount = texture.texture.levels.size();
+        residency.width = level.width;
+        residency.height = level.height;
+        residency.residentBytes = 0;
+        for (size_t l = texture.residentLevel; l < texture.texture.levels.size(); l++)
+            residency.residentBytes += texture.texture.levels[l].size;
+    }
+};
+#endif
@@ -0,0 +1,198 @@
+#ifndef TEXTURE_REGISTRY_H
+#define TEXTURE_REGISTRY_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/hash.h>
+#include <learnopengl/mapped_file.h>
+#include <learnopengl/scene_pack.h>
+#include <learnopengl/texture_loader.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Process-wide registry of loaded textures with reference counted GL names. Every texture in the program (model
+// materials and the ones main.cpp loads directly) goes through acquire(), so each distinct image costs exactly one
+// decode and one GPU allocation no matter how many models or paths refer to it.
+//
+// Lookups go by resolved path first (no file access beyond realpath) and then by a hash of the file content, which
+// catches the same image stored under different names. Identical file bytes decode to identical pixels, so hashing
+// the encoded file is enough and avoids decoding an image just to find out it is a duplicate.
+class TextureRegistry
+{
+public:
+    static TextureRegistry &Instance()
+    {
+        static TextureRegistry instance;
+        return instance;
+    }
+
+    TextureRegistry(const TextureRegistry &) = delete;
+    TextureRegistry &operator=(const TextureRegistry &) = delete;
+
+    // GL thread only: returns the texture for filename with its reference count increased, loading it if needed.
+    // usage only matters for the first acquire of an image, later ones share whatever was loaded.
+    unsigned int acquire(const std::string &filename, Texture_Usage usage = TEXTURE_COLOR)
+    {
+        // images in the mounted scene pack go by their pack name and the content hash recorded when cooking,
+        // so the file system isn't touched for them at all
+        ScenePackSpan packed;
+        bool inPack = ScenePack::Instance().find(filename, PACK_TEXTURE, packed);
+        std::string resolved = inPack ? ScenePack::NormalizePath(filename) : ResolvePath(filename);
+        auto byPath = texturesByPath.find(resolved);
+        if (byPath != texturesByPath.end())
+            return addReference(byPath->second);
+
+        uint64_t contentHash = packed.contentHash;
+        if (!inPack)
+        {
+            MappedFile file(resolved);
+            if (file.isOpen())
+                contentHash = HashContent(file.data(), file.size());
+        }
+        if (contentHash != 0)
+        {
+            auto byContent = texturesByContent.find(contentHash);
+            if (byContent != texturesByContent.end())
+            {
+                texturesByPath[resolved] = byContent->second;
+                entries[byContent->second].paths.push_back(resolved);
+                return addReference(byContent->second);
+            }
+        }
+
+        unsigned int textureID = TextureLoader::Instance().request(resolved, usage, contentHash);
+        Entry &entry = entries[textureID];
+        entry.references = 1;
+        entry.usage = usage;
+        entry.contentHash = contentHash;
+        entry.paths.push_back(resolved);
+        texturesByPath[resolved] = textureID;
+        if (contentHash != 0)
+            texturesByContent[contentHash] = textureID;
+        return textureID;
+    }
+
+    // GL thread only: drops one reference, the texture is deleted together with its last reference
+    void release(unsigned int textureID)
+    {
+        auto it = entries.find(textureID);
+        if (it == entries.end() || --it->second.references > 0)
+            return;
+
+        for (const std::string &path : it->second.paths)
+            texturesByPath.erase(path);
+        auto byContent = texturesByContent.find(it->second.contentHash);
+        if (byContent != texturesByContent.end() && byContent->second == textureID)
+            texturesByContent.erase(byContent);
+        entries.erase(it);
+
+        TextureLoader::Instance().cancel(textureID);
+        glDeleteTextures(1, &textureID);
+    }
+
+    // GL thread only: the image at filename changed on disk, loads it again into the texture that holds it (see
+    // TextureLoader::reload). A texture shared with other paths only because their files were identical is left to
+    // them: filename is taken off it, and its next acquire loads a texture of its own (see ModelStreamer::reload).
+    // Returns false if no texture holds filename.
+    bool reload(const std::string &filename)
+    {
+        auto byPath = find(filename);
+        if (byPath == texturesByPath.end())
+            return false;
+
+        uint64_t contentHash = 0;
+        {
+            MappedFile file(filename);
+            if (file.isOpen())
+                contentHash = HashContent(file.data(), file.size());
+        }
+        unsigned int textureID = byPath->second;
+        Entry &entry = entries[textureID];
+        if (contentHash != 0 && contentHash == entry.contentHash)
+            return true;    // touched, not changed
+
+        if (entry.paths.size() > 1)
+        {
+            // the holders keep the old texture until they acquire filename again, nothing is loaded for nobody
+            entry.paths.erase(std::find(entry.paths.begin(), entry.paths.end(), byPath->first));
+            texturesByPath.erase(byPath);
+            std::cout << "TextureRegistry: " << filename << ": no longer shared, loaded again on its next acquire" << std::endl;
+            return true;
+        }
+
+        auto byContent = texturesByContent.find(entry.contentHash);
+        if (byContent != texturesByContent.end() && byContent->second == textureID)
+            texturesByContent.erase(byContent);
+        entry.contentHash = contentHash;
+        if (contentHash != 0 && texturesByContent.find(contentHash) == texturesByContent.end())
+            texturesByContent[contentHash] = textureID;
+        TextureLoader::Instance().reload(textureID, byPath->first, entry.usage, contentHash);
+        std::cout << "TextureRegistry: " << filename << ": reloading" << std::endl;
+        return true;
+    }
+
+    // the texture that holds filename, 0 if none does (acquire() would load it). Doesn't add a reference.
+    unsigned int textureFor(const std::string &filename) const
+    {
+        auto byPath = find(filename);
+        return byPath == texturesByPath.end() ? 0 : byPath->second;
+    }
+
+    unsigned int referenceCount(unsigned int textureID) const
+    {
+        auto it = entries.find(textureID);
+        return it == entries.end() ? 0 : it->second.references;
+    }
+
+    // number of distinct textures alive, i.e. decodes and GPU allocations made
+    size_t size() const
+    {
+        return entries.size();
+    }
+
+    // canonical form of a path, so "a/../b.png" and "b.png" share an entry. Falls back to the path itself.
+    static std::string ResolvePath(const std::string &path)
+    {
+        char buffer[PATH_MAX];
+        if (realpath(path.c_str(), buffer))
+            return buffer;
+        return path;
+    }
+
+private:
+    struct Entry {
+        unsigned int references = 0;
+        Texture_Usage usage = TEXTURE_COLOR;
+        uint64_t contentHash = 0;
+        std::vector<std::string> paths;
+    };
+
+    std::unordered_map<unsigned int, Entry> entries;
+    std::unordered_map<std::string, unsigned int> texturesByPath;
+    std::unordered_map<uint64_t, unsigned int> texturesByContent;
+
+    TextureRegistry()
+    {
+    }
+
+    std::unordered_map<std::string, unsigned int>::const_iterator find(const std::string &filename) const
+    {
+        auto byPath = texturesByPath.find(ResolvePath(filename));
+        if (byPath == texturesByPath.end())
+            byPath = texturesByPath.find(ScenePack::NormalizePath(filename));
+        return byPath;
+    }
+
+    unsigned int addReference(unsigned int textureID)
+    {
+        entries[textureID].references++;
+        return textureID;
+    }
+};
+#endif
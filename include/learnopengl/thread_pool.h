@@ -0,0 +1,122 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed size pool of worker threads. Tasks may enqueue further tasks, wait() blocks until the queue is drained
+// and every task (including the ones enqueued while waiting) has finished.
+class ThreadPool
+{
+public:
+    // threadCount == 0 uses one thread per hardware core
+    explicit ThreadPool(unsigned int threadCount = 0) : pending(0), stopping(false)
+    {
+        if (threadCount == 0)
+            threadCount = std::thread::hardware_concurrency();
+        if (threadCount == 0)
+            threadCount = 4;
+        for (unsigned int i = 0; i < threadCount; i++)
+            workers.emplace_back([this]() { workerLoop(); });
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        taskAvailable.notify_all();
+        for (std::thread &worker : workers)
+            worker.join();
+    }
+
+    void enqueue(std::function<void()> task)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push_back(std::move(task));
+            pending++;
+        }
+        taskAvailable.notify_one();
+    }
+
+    // barrier: returns once all submitted work is done
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        allDone.wait(lock, [this]() { return pending == 0; });
+    }
+
+    unsigned int size() const
+    {
+        return workers.size();
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable taskAvailable;
+    std::condition_variable allDone;
+    unsigned int pending;
+    bool stopping;
+
+    void workerLoop()
+    {
+        for (;;)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                taskAvailable.wait(lock, [this]() { return stopping || !tasks.empty(); });
+                if (tasks.empty())
+                    return;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--pending == 0)
+                    allDone.notify_all();
+            }
+        }
+    }
+};
+
+// runs body(0) ... body(count - 1) on the pool and returns once all of them are done. Unlike wait() this only waits
+// for its own items, so several threads may share one pool. Must not be called from a task of that same pool.
+// A null pool runs everything on the calling thread.
+inline void ParallelFor(ThreadPool *pool, size_t count, const std::function<void(size_t)> &body)
+{
+    if (!pool || count <= 1)
+    {
+        for (size_t i = 0; i < count; i++)
+            body(i);
+        return;
+    }
+
+    std::mutex mutex;
+    std::condition_variable done;
+    size_t remaining = count;
+    for (size_t i = 0; i < count; i++)
+    {
+        pool->enqueue([&, i]() {
+            body(i);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--remaining == 0)
+                done.notify_all();
+        });
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&]() { return remaining == 0; });
+}
+#endif
@@ -0,0 +1,220 @@
+#ifndef UNIFORM_H
+#define UNIFORM_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <learnopengl/hash.h>
+
+#include <algorithm>
+#include <deque>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Uniform locations without asking the driver in the frame loop. A shader enumerates the active uniforms of its
+// program once after linking (UniformTable::build); set*() calls then only look up a hash, and Uniform handles
+// resolved up front don't even do that:
+//
+//     Uniform<glm::mat4> modelMatrix = shader.uniform<glm::mat4>("model");     // once
+//     ...
+//     shader.use();
+//     modelMatrix.set(model);                                                  // every draw
+//
+// Like the set*() functions a handle sets the uniform of the program in use.
+
+// name of a uniform by its hash, so finding one neither allocates nor compares strings. Names known at compile
+// time can be hashed by the compiler: constexpr UniformName positionScale("positionScale");
+struct UniformName
+{
+    uint64_t hash;
+
+    constexpr UniformName(const char *name) : hash(HashName(name))
+    {
+    }
+    UniformName(const std::string &name) : hash(HashBytes(name.data(), name.size()))
+    {
+    }
+};
+
+inline void SetUniform(GLint location, bool value)              { glUniform1i(location, (int)value); }
+inline void SetUniform(GLint location, int value)               { glUniform1i(location, value); }
+inline void SetUniform(GLint location, float value)             { glUniform1f(location, value); }
+inline void SetUniform(GLint location, const glm::vec2 &value)  { glUniform2fv(location, 1, &value[0]); }
+inline void SetUniform(GLint location, const glm::vec3 &value)  { glUniform3fv(location, 1, &value[0]); }
+inline void SetUniform(GLint location, const glm::vec4 &value)  { glUniform4fv(location, 1, &value[0]); }
+inline void SetUniform(GLint location, const glm::mat2 &mat)    { glUniformMatrix2fv(location, 1, GL_FALSE, &mat[0][0]); }
+inline void SetUniform(GLint location, const glm::mat3 &mat)    { glUniformMatrix3fv(location, 1, GL_FALSE, &mat[0][0]); }
+inline void SetUniform(GLint location, const glm::mat4 &mat)    { glUniformMatrix4fv(location, 1, GL_FALSE, &mat[0][0]); }
+
+// a uniform of type T resolved once, see UniformTable::handle. Setting a uniform the program doesn't have
+// (optimized out, misspelled) does nothing, as with glUniform and location -1.
+template <typename T>
+class Uniform
+{
+public:
+    Uniform() : location(&missing)
+    {
+    }
+
+    void set(const T &value) const
+    {
+        SetUniform(*location, value);
+    }
+
+    bool isActive() const
+    {
+        return *location >= 0;
+    }
+
+private:
+    friend class UniformTable;
+    static const GLint missing;
+    const GLint *location;      // owned by the table, follows its rebuilds
+
+    explicit Uniform(const GLint *location) : location(location)
+    {
+    }
+};
+
+template <typename T>
+const GLint Uniform<T>::missing = -1;
+
+// binding point and std140 size of a uniform block, see BindUniformBlock
+struct UniformBlockBinding
+{
+    GLuint binding;
+    GLint size;
+};
+
+inline std::unordered_map<std::string, UniformBlockBinding> &UniformBlockBindings()
+{
+    static std::unordered_map<std::string, UniformBlockBinding> bindings;
+    return bindings;
+}
+
+// every program with a uniform block of this name reads it from binding (GLSL 330 has no layout(binding = N), so
+// UniformTable::build sets it after linking). size is what the C++ side writes, a program that declares a larger
+// block gets a warning. Register blocks before building the shaders.
+inline void BindUniformBlock(const std::string &block, GLuint binding, size_t size)
+{
+    UniformBlockBindings()[block] = UniformBlockBinding{binding, GLint(size)};
+}
+
+// the active uniforms of a linked program by name. Arrays of basic types can be found by their name with and
+// without "[0]" as well as by each element ("weights[3]"); members of struct arrays are uniforms of their own
+// ("pointLights[1].position").
+class UniformTable
+{
+public:
+    UniformTable() : generation(0)
+    {
+    }
+
+    // handles point into the table
+    UniformTable(const UniformTable &) = delete;
+    UniformTable &operator=(const UniformTable &) = delete;
+
+    // GL thread: enumerates program, once after it linked. Handles handed out before move over to the new
+    // locations, so a shader rebuilds its table when it swaps in a reloaded program.
+    void build(unsigned int program)
+    {
+        static uint64_t builds = 0;
+        generation = ++builds;
+        locations.clear();
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(program, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::vector<GLchar> name(std::max(maxLength, 1));
+        for (GLint i = 0; i < count; i++)
+        {
+            GLsizei nameLength = 0;
+            GLint size = 0;
+            GLenum type = 0;
+            glGetActiveUniform(program, i, (GLsizei) name.size(), &nameLength, &size, &type, name.data());
+            std::string uniformName(name.data(), nameLength);
+            GLint location = glGetUniformLocation(program, uniformName.c_str());
+            if (location < 0)
+                continue;   // in a uniform block
+            locations[UniformName(uniformName).hash] = location;
+            if (uniformName.size() > 3 && uniformName.compare(uniformName.size() - 3, 3, "[0]") == 0)
+            {
+                std::string base = uniformName.substr(0, uniformName.size() - 3);
+                locations[UniformName(base).hash] = location;
+                for (GLint element = 1; element < size; element++)
+                {
+                    std::string elementName = base + "[" + std::to_string(element) + "]";
+                    locations[UniformName(elementName).hash] = glGetUniformLocation(program, elementName.c_str());
+                }
+            }
+        }
+        for (auto &handle : handles)
+            handle.second = find(handle.first);
+        bindBlocks(program);
+    }
+
+    // location of the uniform, -1 if the program has no such uniform
+    GLint location(UniformName name) const
+    {
+        return find(name.hash);
+    }
+
+    // changes with every build, of any table, so locations copied out of a table can tell when they are stale.
+    // 0 until the first build.
+    uint64_t getGeneration() const
+    {
+        return generation;
+    }
+
+    // a handle to set the uniform through. Resolve them outside the frame loop, each name takes one slot.
+    template <typename T>
+    Uniform<T> handle(UniformName name)
+    {
+        for (auto &existing : handles)
+            if (existing.first == name.hash)
+                return Uniform<T>(&existing.second);
+        handles.emplace_back(name.hash, find(name.hash));
+        return Uniform<T>(&handles.back().second);
+    }
+
+private:
+    std::unordered_map<uint64_t, GLint> locations;
+    uint64_t generation;
+    std::deque<std::pair<uint64_t, GLint>> handles;    // name -> location of the handles given out, never moves
+
+    // points the program's uniform blocks at their binding points
+    static void bindBlocks(unsigned int program)
+    {
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &count);
+        glGetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxLength);
+        std::vector<GLchar> name(std::max(maxLength, 1));
+        for (GLint i = 0; i < count; i++)
+        {
+            GLsizei nameLength = 0;
+            glGetActiveUniformBlockName(program, i, (GLsizei) name.size(), &nameLength, name.data());
+            std::string blockName(name.data(), nameLength);
+            auto binding = UniformBlockBindings().find(blockName);
+            if (binding == UniformBlockBindings().end())
+            {
+                std::cout << "WARNING::UNIFORM:: block " << blockName << " has no binding point" << std::endl;
+                continue;
+            }
+            GLint size = 0;
+            glGetActiveUniformBlockiv(program, i, GL_UNIFORM_BLOCK_DATA_SIZE, &size);
+            if (size > binding->second.size)
+                std::cout << "WARNING::UNIFORM:: block " << blockName << " is " << size << " bytes in the shader, only "
+                          << binding->second.size << " are written" << std::endl;
+            glUniformBlockBinding(program, i, binding->second.binding);
+        }
+    }
+
+    GLint find(uint64_t hash) const
+    {
+        auto found = locations.find(hash);
+        return found != locations.end() ? found->second : -1;
+    }
+};
+#endif
@@ -0,0 +1,165 @@
+#ifndef UNIFORM_BUFFER_H
+#define UNIFORM_BUFFER_H
+
+#include <glad/glad.h>
+
+#include <learnopengl/gl_extensions.h>
+
+#include <cstring>
+#include <iostream>
+
+// Per-frame data shared by many shaders (camera, lights) in uniform blocks, written once a frame instead of once
+// per program. The blocks of a frame go into one slot of a buffer with UNIFORM_RING_FRAMES slots, so the CPU
+// writes the next frame while the GPU may still read the ones before; a fence per slot keeps the CPU from running
+// further ahead than that.
+//
+// With GL 4.4 or ARB_buffer_storage the buffer stays mapped for good (persistent, coherent). Otherwise each block
+// is written through glMapBufferRange with GL_MAP_UNSYNCHRONIZED_BIT, which the fences make safe, so the driver
+// never waits for the GPU or copies the buffer.
+//
+//     UniformBufferRing ring(sizeof(CameraBlock) + sizeof(LightsBlock), 2);
+//     ...
+//     ring.beginFrame();                          // every frame, before the first write
+//     ring.write(CAMERA_BLOCK_BINDING, camera);   // bound to the binding point until the next frame
+//     ring.write(LIGHTS_BLOCK_BINDING, lights);
+//
+// The C++ structs have to match the std140 layout of the blocks, see BindUniformBlock.
+
+// frames the CPU may be ahead of the GPU
+const unsigned int UNIFORM_RING_FRAMES = 3;
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT   0x0080
+#endif
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+
+class UniformBufferRing
+{
+public:
+    // GL thread: bytesPerFrame is what the blocksPerFrame write() calls of a frame take together
+    UniformBufferRing(size_t bytesPerFrame, unsigned int blocksPerFrame)
+        : slot(0), cursor(0), persistent(nullptr), frameStarted(false)
+    {
+        GLint offsetAlignment = 256;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+        alignment = offsetAlignment > 0 ? size_t(offsetAlignment) : 256;
+        // blocks start at multiples of the alignment
+        slotSize = align(bytesPerFrame + blocksPerFrame * (alignment - 1));
+        for (GLsync &fence : fences)
+            fence = nullptr;
+
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+        GLsizeiptr size = GLsizeiptr(slotSize * UNIFORM_RING_FRAMES);
+        PFNGLBUFFERSTORAGEPROC bufferStorage = nullptr;
+        GLint major = 0, minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+        if (major > 4 || (major == 4 && minor >= 4) || HasExtension("GL_ARB_buffer_storage"))
+            bufferStorage = LoadExtensionFunction<PFNGLBUFFERSTORAGEPROC>("glBufferStorage");
+        if (bufferStorage)
+        {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            bufferStorage(GL_UNIFORM_BUFFER, size, nullptr, flags);
+            persistent = static_cast<unsigned char*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, size, flags));
+        }
+        if (!persistent)
+            glBufferData(GL_UNIFORM_BUFFER, size, nullptr, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    }
+
+    UniformBufferRing(const UniformBufferRing &) = delete;
+    UniformBufferRing &operator=(const UniformBufferRing &) = delete;
+
+    ~UniformBufferRing()
+    {
+        for (GLsync fence : fences)
+            if (fence)
+                glDeleteSync(fence);
+        if (persistent)
+        {
+            glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+            glUnmapBuffer(GL_UNIFORM_BUFFER);
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        }
+        glDeleteBuffers(1, &buffer);
+    }
+
+    // GL thread, once per frame before its writes: fences the slot of the previous frame (all its draws have been
+    // issued by now) and moves on to the next one, waiting in the rare case the GPU still reads it
+    void beginFrame()
+    {
+        if (frameStarted)
+        {
+            fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            slot = (slot + 1) % UNIFORM_RING_FRAMES;
+        }
+        frameStarted = true;
+        cursor = 0;
+        if (fences[slot])
+        {
+            GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+            while (glClientWaitSync(fences[slot], flags, 1000000) == GL_TIMEOUT_EXPIRED)
+                flags = 0;
+            glDeleteSync(fences[slot]);
+            fences[slot] = nullptr;
+        }
+    }
+
+    // GL thread: copies block into this frame's slot and binds it to the binding point, where it stays for the
+    // rest of the frame
+    template <typename T>
+    void write(GLuint binding, const T &block)
+    {
+        write(binding, &block, sizeof(T));
+    }
+
+    void write(GLuint binding, const void *data, size_t size)
+    {
+        if (cursor + size > slotSize)
+        {
+            std::cout << "ERROR::UNIFORM_BUFFER:: " << cursor + size << " bytes written in one frame, the ring has "
+                      << slotSize << " per frame" << std::endl;
+            return;
+        }
+        size_t offset = slot * slotSize + cursor;
+        if (persistent)
+            memcpy(persistent + offset, data, size);
+        else
+        {
+            glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+            void *mapped = glMapBufferRange(GL_UNIFORM_BUFFER, offset, size,
+                                            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+            if (mapped)
+            {
+                memcpy(mapped, data, size);
+                glUnmapBuffer(GL_UNIFORM_BUFFER);
+            }
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        }
+        glBindBufferRange(GL_UNIFORM_BUFFER, binding, buffer, offset, size);
+        cursor = align(cursor + size);
+    }
+
+    bool isPersistent() const
+    {
+        return persistent != nullptr;
+    }
+
+private:
+    unsigned int buffer;
+    size_t alignment;
+    size_t slotSize;
+    unsigned int slot;          // slot of the current frame
+    size_t cursor;              // next free byte in it
+    unsigned char *persistent;  // the whole buffer while it stays mapped, nullptr if every write maps
+    bool frameStarted;
+    GLsync fences[UNIFORM_RING_FRAMES];
+
+    size_t align(size_t offset) const
+    {
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+};
+#endif
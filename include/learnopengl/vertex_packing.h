@@ -0,0 +1,246 @@
+#ifndef VERTEX_PACKING_H
+#define VERTEX_PACKING_H
+
+#include <learnopengl/mesh.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Conversion of imported meshes to the packed vertex layout (see VertexFormat) and to 16-bit indices where the
+// vertex count allows. The vertex layout is chosen per mesh so the precision loss stays below what can be seen:
+// positions are quantized only if the mesh bounds are small enough for int16 to resolve
+// POSITION_QUANTIZATION_TOLERANCE, texture coordinates become half floats only if they stay close to [0, 1].
+
+// largest position error (model units) accepted from int16 quantization
+const float POSITION_QUANTIZATION_TOLERANCE = 1e-4f;
+// largest texture coordinate error accepted from half floats, half a texel of a 1K texture
+const float TEXCOORD_HALF_TOLERANCE = 1.0f / 2048.0f;
+
+// IEEE half float, round to nearest even. Inputs beyond the half range become infinity.
+inline uint16_t FloatToHalf(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint16_t sign = (bits >> 16) & 0x8000;
+    uint32_t magnitude = bits & 0x7FFFFFFF;
+
+    if (magnitude >= 0x7F800000)                            // inf or NaN
+        return sign | 0x7C00 | (magnitude > 0x7F800000 ? 0x200 : 0);
+    if (magnitude >= 0x477FF000)                            // rounds past the largest half
+        return sign | 0x7C00;
+    if (magnitude < 0x38800000)                             // half denormal (or zero)
+    {
+        float scaled;
+        memcpy(&scaled, &magnitude, sizeof(scaled));
+        return sign | (uint16_t)std::nearbyint(scaled * 16777216.0f);    // in units of 2^-24
+    }
+    uint32_t rounded = magnitude + 0xFFF + ((magnitude >> 13) & 1);
+    return sign | (uint16_t)((rounded - 0x38000000) >> 13);
+}
+
+inline float HalfToFloat(uint16_t half)
+{
+    uint32_t sign = uint32_t(half & 0x8000) << 16;
+    uint32_t exponent = (half >> 10) & 0x1F;
+    uint32_t mantissa = half & 0x3FF;
+    if (exponent == 0)
+        return (half & 0x8000 ? -1.0f : 1.0f) * mantissa / 16777216.0f;
+    uint32_t bits = sign | (exponent == 31 ? 0x7F800000 | (mantissa << 13) : ((exponent + 112) << 23) | (mantissa << 13));
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// GL_INT_2_10_10_10_REV with normalized x, y, z in [-1, 1] and w either 1 or -1
+inline uint32_t PackSnorm1010102(const glm::vec3 &v, float w)
+{
+    auto component = [](float value) {
+        int c = (int)std::lround(std::min(1.0f, std::max(-1.0f, value)) * 511.0f);
+        return uint32_t(c) & 0x3FF;
+    };
+    uint32_t packedW = w < 0.0f ? 2u : 1u;    // -2 and 1 as 2 bit signed values, both formulas GL uses map them to -1 and 1
+    return component(v.x) | (component(v.y) << 10) | (component(v.z) << 20) | (packedW << 30);
+}
+
+// inverse of PackSnorm1010102, w receives the sign in the top two bits
+inline glm::vec3 UnpackSnorm1010102(uint32_t packed, float *w = nullptr)
+{
+    auto component = [](uint32_t bits) {
+        int value = int32_t(bits << 22) >> 22;      // sign extend the low 10 bits
+        return std::max(-1.0f, value / 511.0f);
+    };
+    if (w)
+        *w = (packed >> 30) == 1 ? 1.0f : -1.0f;
+    return glm::vec3(component(packed), component(packed >> 10), component(packed >> 20));
+}
+
+// position of the vertex at data in the given layout, in model space
+inline glm::vec3 UnpackPosition(const unsigned char *data, const VertexFormat &format)
+{
+    glm::vec3 position;
+    if (format.quantizedPositions)
+    {
+        short quantized[3];
+        memcpy(quantized, data, sizeof(quantized));
+        for (int c = 0; c < 3; c++)
+            position[c] = std::max(-1.0f, quantized[c] / 32767.0f);
+        return position * format.positionScale + format.positionOffset;
+    }
+    memcpy(&position[0], data + (format.packed ? 0 : offsetof(Vertex, Position)), 3 * sizeof(float));
+    return position;
+}
+
+// the vertex at data in the given layout, as far as the layout preserves it
+inline Vertex UnpackVertex(const unsigned char *data, const VertexFormat &format)
+{
+    Vertex vertex;
+    if (!format.packed)
+    {
+        memcpy(&vertex, data, sizeof(Vertex));
+        return vertex;
+    }
+    vertex.Position = UnpackPosition(data, format);
+    uint32_t normal, tangent;
+    memcpy(&normal, data + format.normalOffset(), sizeof(normal));
+    memcpy(&tangent, data + format.tangentOffset(), sizeof(tangent));
+    float handedness;
+    vertex.Normal = UnpackSnorm1010102(normal);
+    vertex.Tangent = UnpackSnorm1010102(tangent, &handedness);
+    vertex.Bitangent = glm::cross(vertex.Normal, vertex.Tangent) * handedness;
+    if (format.halfTexCoords)
+    {
+        uint16_t texCoords[2];
+        memcpy(texCoords, data + format.texCoordsOffset(), sizeof(texCoords));
+        vertex.TexCoords = glm::vec2(HalfToFloat(texCoords[0]), HalfToFloat(texCoords[1]));
+    }
+    else
+        memcpy(&vertex.TexCoords[0], data + format.texCoordsOffset(), 2 * sizeof(float));
+    return vertex;
+}
+
+// fills the CPU side copies residency asks for into an uploaded mesh from the data it was uploaded from.
+// Only the full detail level goes into indices.
+inline void KeepGeometry(const MeshData &data, Geometry_Residency residency, Mesh &mesh)
+{
+    if (residency == GEOMETRY_DISCARD)
+        return;
+
+    const unsigned char *vertexData = static_cast<const unsigned char*>(data.vertexData());
+    unsigned int vertexCount = data.vertexCount(), stride = data.format.stride();
+    if (residency == GEOMETRY_KEEP)
+    {
+        mesh.vertices.resize(vertexCount);
+        for (unsigned int v = 0; v < vertexCount; v++)
+            mesh.vertices[v] = UnpackVertex(vertexData + size_t(v) * stride, data.format);
+    }
+    else
+    {
+        mesh.positions.resize(vertexCount);
+        for (unsigned int v = 0; v < vertexCount; v++)
+            mesh.positions[v] = UnpackPosition(vertexData + size_t(v) * stride, data.format);
+    }
+
+    unsigned int first = data.lods.empty() ? 0 : data.lods[0].indexOffset;
+    unsigned int count = data.lods.empty() ? data.indexCount() : data.lods[0].indexCount;
+    if (data.indexType == GL_UNSIGNED_SHORT)
+    {
+        const uint16_t *indices = static_cast<const uint16_t*>(data.indexData()) + first;
+        mesh.indices.assign(indices, indices + count);
+    }
+    else
+    {
+        const unsigned int *indices = static_cast<const unsigned int*>(data.indexData()) + first;
+        mesh.indices.assign(indices, indices + count);
+    }
+}
+
+// picks the packed layout for a mesh, see the tolerances above
+inline VertexFormat ChooseVertexFormat(const vector<Vertex> &vertices)
+{
+    VertexFormat format;
+    format.packed = true;
+    if (vertices.empty())
+        return format;
+
+    glm::vec3 low = vertices[0].Position, high = vertices[0].Position;
+    bool halfTexCoords = true;
+    for (const Vertex &vertex : vertices)
+    {
+        low = glm::min(low, vertex.Position);
+        high = glm::max(high, vertex.Position);
+        for (int c = 0; c < 2 && halfTexCoords; c++)
+            if (std::fabs(HalfToFloat(FloatToHalf(vertex.TexCoords[c])) - vertex.TexCoords[c]) > TEXCOORD_HALF_TOLERANCE)
+                halfTexCoords = false;
+    }
+    format.halfTexCoords = halfTexCoords;
+
+    // normalized shorts cover [-32767, 32767] around the center of the bounds, the error is half a step
+    glm::vec3 halfExtent = (high - low) * 0.5f;
+    float largest = std::max(halfExtent.x, std::max(halfExtent.y, halfExtent.z));
+    if (largest / 32767.0f * 0.5f <= POSITION_QUANTIZATION_TOLERANCE)
+    {
+        format.quantizedPositions = true;
+        format.positionOffset = (low + high) * 0.5f;
+        // a flat axis still needs a nonzero scale to divide by
+        format.positionScale = glm::max(halfExtent, glm::vec3(1e-8f));
+    }
+    return format;
+}
+
+// converts the owned vertices of an imported mesh to the format ChooseVertexFormat picks for them
+inline void PackVertices(MeshData &mesh)
+{
+    VertexFormat format = ChooseVertexFormat(mesh.vertices);
+    unsigned int stride = format.stride();
+    vector<unsigned char> packed(mesh.vertices.size() * stride);
+
+    unsigned char *out = packed.data();
+    for (const Vertex &vertex : mesh.vertices)
+    {
+        if (format.quantizedPositions)
+        {
+            short position[4] = {0, 0, 0, 0};
+            glm::vec3 normalized = (vertex.Position - format.positionOffset) / format.positionScale;
+            for (int c = 0; c < 3; c++)
+                position[c] = (short)std::lround(std::min(1.0f, std::max(-1.0f, normalized[c])) * 32767.0f);
+            memcpy(out, position, sizeof(position));
+        }
+        else
+            memcpy(out, &vertex.Position[0], 3 * sizeof(float));
+
+        uint32_t normal = PackSnorm1010102(vertex.Normal, 1.0f);
+        float handedness = glm::dot(glm::cross(vertex.Normal, vertex.Tangent), vertex.Bitangent) < 0.0f ? -1.0f : 1.0f;
+        uint32_t tangent = PackSnorm1010102(vertex.Tangent, handedness);
+        memcpy(out + format.normalOffset(), &normal, sizeof(normal));
+        memcpy(out + format.tangentOffset(), &tangent, sizeof(tangent));
+
+        if (format.halfTexCoords)
+        {
+            uint16_t texCoords[2] = {FloatToHalf(vertex.TexCoords.x), FloatToHalf(vertex.TexCoords.y)};
+            memcpy(out + format.texCoordsOffset(), texCoords, sizeof(texCoords));
+        }
+        else
+            memcpy(out + format.texCoordsOffset(), &vertex.TexCoords[0], 2 * sizeof(float));
+        out += stride;
+    }
+
+    mesh.format = format;
+    mesh.packedVertices.swap(packed);
+    vector<Vertex>().swap(mesh.vertices);
+}
+
+// switches an imported mesh to 16-bit indices if it has few enough vertices, halving its index buffer.
+// Call before PackVertices, which empties vertices.
+inline void PackIndices(MeshData &mesh)
+{
+    if (mesh.vertices.size() > SHORT_INDEX_VERTEX_LIMIT)
+        return;
+    mesh.shortIndices.assign(mesh.indices.begin(), mesh.indices.end());
+    mesh.indexType = GL_UNSIGNED_SHORT;
+    vector<unsigned int>().swap(mesh.indices);
+}
+#endif
@@ -0,0 +1,6 @@
+// camera of the frame, written once per frame into a uniform buffer (CameraBlock in main.cpp, same std140 layout)
+layout (std140) uniform Camera {
+    mat4 projection;
+    mat4 view;
+    vec3 viewPos;
+};
@@ -5,10 +5,18 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+// counts heap allocations per thread for the model loading statistics, see allocation_counter.h
+#define ALLOCATION_COUNTER_IMPLEMENTATION
+#include <learnopengl/allocation_counter.h>
 #include <learnopengl/filesystem.h>
 #include <learnopengl/shader_m.h>
+#include <learnopengl/uniform_buffer.h>
 #include <learnopengl/camera.h>
+#include <learnopengl/file_watcher.h>
 #include <learnopengl/model.h>
+#include <learnopengl/model_streamer.h>
+#include <learnopengl/render_queue.h>
+#include <learnopengl/scene_pack.h>
 
 #include <iostream>
 
@@ -17,12 +25,13 @@ void mouse_callback(GLFWwindow *window, double xpos, double ypos);
 void scroll_callback(GLFWwindow *window, double xoffset, double yoffset);
 void processInput(GLFWwindow *window);
 void key_callback(GLFWwindow *window, int key, int scancode, int action, int mods);
-unsigned int loadTexture(const char *path);
+unsigned int loadTexture(const char *path, Texture_Usage usage);
 
 // settings
 const unsigned int SCR_WIDTH = 1200;
 const unsigned int SCR_HEIGHT = 800;
 const unsigned int NUM_LIGHT_CUBES = 2;
+const unsigned int NUM_SPOT_LIGHTS = 2;
 
 // camera
 Camera camera(glm::vec3(0.0f, 1.0f, 6.0f));
@@ -34,6 +43,64 @@ bool firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
+// uniform blocks shared by all shaders (resources/shaders/camera.glsl and lights.glsl), written once per frame.
+// The structs mirror the std140 layout: a vec3 takes 16 bytes unless a float follows it, structs in arrays are
+// padded to 16 bytes.
+const GLuint CAMERA_BLOCK_BINDING = 0;
+const GLuint LIGHTS_BLOCK_BINDING = 1;
+
+struct CameraBlock {
+    glm::mat4 projection;
+    glm::mat4 view;
+    glm::vec3 viewPos;
+    float padding;
+};
+
+struct DirLightBlock {
+    glm::vec3 direction;
+    float padding0;
+    glm::vec3 ambient;
+    float padding1;
+    glm::vec3 diffuse;
+    float padding2;
+    glm::vec3 specular;
+    float padding3;
+};
+
+struct PointLightBlock {
+    glm::vec3 position;
+    float constant;
+    glm::vec3 ambient;
+    float linear;
+    glm::vec3 diffuse;
+    float quadratic;
+    glm::vec3 specular;
+    float padding;
+};
+
+struct SpotLightBlock {
+    glm::vec3 position;
+    float cutOff;
+    glm::vec3 direction;
+    float outerCutOff;
+    glm::vec3 ambient;
+    float constant;
+    glm::vec3 diffuse;
+    float linear;
+    glm::vec3 specular;
+    float quadratic;
+};
+
+struct LightsBlock {
+    DirLightBlock dirLight;
+    PointLightBlock pointLights[NUM_LIGHT_CUBES];
+    SpotLightBlock spotLights[NUM_SPOT_LIGHTS];
+};
+
+static_assert(sizeof(CameraBlock) == 144, "CameraBlock doesn't match the std140 layout of Camera");
+static_assert(sizeof(DirLightBlock) == 64 && sizeof(PointLightBlock) == 64 && sizeof(SpotLightBlock) == 80,
+              "light structs don't match the std140 layout of lights.glsl");
+
 
 int main() {
     // glfw: initialize and configure
@@ -66,870 +133,515 @@ int main() {
         std::cout << "Failed to initialize GLAD" << std::endl;
         return -1;
     }
+    // the same loader for the extension functions glad doesn't cover
+    SetExtensionLoader((GLADloadproc) glfwGetProcAddress);
 
-    // Leaving this comment here intentionally.
-    // tell stb_image.h to flip loaded texture's on the y-axis (before loading model)
-    // no - models in this project have textures with different texture origin
-//    stbi_set_flip_vertically_on_load(true);
-
-    // configure global opengl state
-    glEnable(GL_DEPTH_TEST);
-
-    // build and compile shaders
-    Shader platform1Shader("resources/shaders/platform1.vs", "resources/shaders/platform1.fs");
-    Shader platform2Shader("resources/shaders/platform2.vs", "resources/shaders/platform2.fs");
-    Shader wall1Shader("resources/shaders/wall1.vs", "resources/shaders/wall1.fs" );
-    Shader wall2Shader("resources/shaders/wall2.vs", "resources/shaders/wall2.fs" );
-    Shader stairsShader("resources/shaders/stairs.vs", "resources/shaders/stairs.fs");
-    Shader lightCubeShader("resources/shaders/lightCube.vs", "resources/shaders/lightCube.fs");
-    Shader modelShader("resources/shaders/model.vs", "resources/shaders/model.fs");
-
-    // basic cube vertices - to be used for drawing platforms
-    float platformVertices[] = {
-            // positions                // normals              //texture coords
-            // back face (CCW winding)
-            0.5f, -0.5f, -0.5f, 0.0f,  0.0f, -1.0f,  0.0f, 0.0f, // bottom-left
-            -0.5f, -0.5f, -0.5f, 0.0f,  0.0f, -1.0f, 4.0f, 0.0f, // bottom-right
-            -0.5f,  0.5f, -0.5f, 0.0f,  0.0f, -1.0f, 4.0f, 4.0f, // top-right
-            -0.5f,  0.5f, -0.5f, 0.0f,  0.0f, -1.0f, 4.0f, 4.0f, // top-right
-            0.5f,  0.5f, -0.5f, 0.0f,  0.0f, -1.0f, 0.0f, 4.0f, // top-left
-            0.5f, -0.5f, -0.5f, 0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
-            // front face (CCW winding)
-            -0.5f, -0.5f,  0.5f, 0.0f,  0.0f,  1.0f,  0.0f, 0.0f, // bottom-left
-            0.5f, -0.5f,  0.5f, 0.0f,  0.0f,  1.0f, 4.0f, 0.0f, // bottom-right
-            0.5f,  0.5f,  0.5f, 0.0f,  0.0f,  1.0f, 4.0f, 4.0f, // top-right
-            0.5f,  0.5f,  0.5f, 0.0f,  0.0f,  1.0f, 4.0f, 4.0f, // top-right
-            -0.5f,  0.5f,  0.5f, 0.0f,  0.0f,  1.0f, 0.0f, 4.0f, // top-left
-            -0.5f, -0.5f,  0.5f, 0.0f,  0.0f,  1.0f, 0.0f, 0.0f, // bottom-left
-            // left face (CCW)
-            -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-left
-            -0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f, 4.0f, 0.0f, // bottom-right
-            -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f, 4.0f, 4.0f, // top-right
-            -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f, 4.0f, 4.0f, // top-right
-            -0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f, 0.0f, 4.0f, // top-left
-            -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-left
-            // right face (CCW)
-            0.5f, -0.5f,  0.5f, 1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-left
-            0.5f, -0.5f, -0.5f, 1.0f,  0.0f,  0.0f, 4.0f, 0.0f, // bottom-right
-            0.5f,  0.5f, -0.5f, 1.0f,  0.0f,  0.0f, 4.0f, 4.0f, // top-right
-            0.5f,  0.5f, -0.5f, 1.0f,  0.0f,  0.0f, 4.0f, 4.0f, // top-right
-            0.5f,  0.5f,  0.5f, 1.0f,  0.0f,  0.0f, 0.0f, 4.0f, // top-left
-            0.5f, -0.5f,  0.5f, 1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-left
-            // bottom face (CCW)
-            -0.5f, -0.5f, -0.5f, 0.0f, -1.0f,  0.0f, 0.0f, 0.0f, // bottom-left
-            0.5f, -0.5f, -0.5f, 0.0f, -1.0f,  0.0f, 4.0f, 0.0f, // bottom-right
-            0.5f, -0.5f,  0.5f, 0.0f, -1.0f,  0.0f, 4.0f, 4.0f, // top-right
-            0.5f, -0.5f,  0.5f, 0.0f, -1.0f,  0.0f, 4.0f, 4.0f, // top-right
-            -0.5f, -0.5f,  0.5f, 0.0f, -1.0f,  0.0f, 0.0f, 4.0f, // top-left
-            -0.5f, -0.5f, -0.5f, 0.0f, -1.0f,  0.0f, 0.0f, 0.0f, // bottom-left
-            // top face (CCW)
-            -0.5f,  0.5f,  0.5f, 0.0f,  1.0f,  0.0f, 0.0f, 0.0f, // bottom-left
-            0.5f,  0.5f,  0.5f, 0.0f,  1.0f,  0.0f, 4.0f, 0.0f, // bottom-right
-            0.5f,  0.5f, -0.5f, 0.0f,  1.0f,  0.0f, 4.0f, 4.0f, // top-right
-            0.5f,  0.5f, -0.5f, 0.0f,  1.0f,  0.0f, 4.0f, 4.0f, // top-right
-            -0.5f,  0.5f, -0.5f, 0.0f,  1.0f,  0.0f, 0.0f, 4.0f, // top-left
-            -0.5f,  0.5f,  0.5f, 0.0f,  1.0f,  0.0f, 0.0f, 0.0f, // bottom-left
-    };
-
-    // basic cube vertices - to be used for drawing walls and light cubes
-    float wallVertices[] = {
-            // positions                // normals              //texture coords
-            // back face (CCW winding)
-            0.5f, -0.5f, -0.5f, 0.0f,  0.0f, -1.0f,  0.0f, 0.0f, // bottom-left
-            -0.5f, -0.5f, -0.5f, 0.0f,  0.0f, -1.0f, 1.0f, 0.0f, // bottom-right
-            -0.5f,  0.5f, -0.5f, 0.0f,  0.0f, -1.0f, 1.0f, 1.0f, // top-right
-            -0.5f,  0.5f, -0.5f, 0.0f,  0.0f, -1.0f, 1.0f, 1.0f, // top-right
-            0.5f,  0.5f, -0.5f, 0.0f,  0.0f, -1.0f, 0.0f, 1.0f, // top-left
-            0.5f, -0.5f, -0.5f, 0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
-            // front face (CCW winding)
-            -0.5f, -0.5f,  0.5f, 0.0f,  0.0f,  1.0f,  0.0f, 0.0f, // bottom-left
-            0.5f, -0.5f,  0.5f, 0.0f,  0.0f,  1.0f, 1.0f, 0.0f, // bottom-right
-            0.5f,  0.5f,  0.5f, 0.0f,  0.0f,  1.0f, 1.0f, 1.0f, // top-right
-            0.5f,  0.5f,  0.5f, 0.0f,  0.0f,  1.0f, 1.0f, 1.0f, // top-right
-            -0.5f,  0.5f,  0.5f, 0.0f,  0.0f,  1.0f, 0.0f, 1.0f, // top-left
-            -0.5f, -0.5f,  0.5f, 0.0f,  0.0f,  1.0f, 0.0f, 0.0f, // bottom-left
-            // left face (CCW)
-            -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-left
-            -0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // bottom-right
-            -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-right
-            -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-right
-            -0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // top-left
-            -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-left
-            // right face (CCW)
-            0.5f, -0.5f,  0.5f, 1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-left
-            0.5f, -0.5f, -0.5f, 1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // bottom-right
-            0.5f,  0.5f, -0.5f, 1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-right
-            0.5f,  0.5f, -0.5f, 1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-right
-            0.5f,  0.5f,  0.5f, 1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // top-left
-            0.5f, -0.5f,  0.5f, 1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-left
-            // bottom face (CCW)
-            -0.5f, -0.5f, -0.5f, 0.0f, -1.0f,  0.0f, 0.0f, 0.0f, // bottom-left
-            0.5f, -0.5f, -0.5f, 0.0f, -1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
-            0.5f, -0.5f,  0.5f, 0.0f, -1.0f,  0.0f, 1.0f, 1.0f, // top-right
-            0.5f, -0.5f,  0.5f, 0.0f, -1.0f,  0.0f, 1.0f, 1.0f, // top-right
-            -0.5f, -0.5f,  0.5f, 0.0f, -1.0f,  0.0f, 0.0f, 1.0f, // top-left
-            -0.5f, -0.5f, -0.5f, 0.0f, -1.0f,  0.0f, 0.0f, 0.0f, // bottom-left
-            // top face (CCW)
-            -0.5f,  0.5f,  0.5f, 0.0f,  1.0f,  0.0f, 0.0f, 0.0f, // bottom-left
-            0.5f,  0.5f,  0.5f, 0.0f,  1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
-            0.5f,  0.5f, -0.5f, 0.0f,  1.0f,  0.0f, 1.0f, 1.0f, // top-right
-            0.5f,  0.5f, -0.5f, 0.0f,  1.0f,  0.0f, 1.0f, 1.0f, // top-right
-            -0.5f,  0.5f, -0.5f, 0.0f,  1.0f,  0.0f, 0.0f, 1.0f, // top-left
-            -0.5f,  0.5f,  0.5f, 0.0f,  1.0f,  0.0f, 0.0f, 0.0f, // bottom-left
-    };
-
-    // platform positions
-    glm::vec3 platformPositions[] = {
-            glm::vec3( -3.0f,  0.5f,  0.0f),
-            glm::vec3( 1.5f, 0.0f, 0.5f)
-    };
-
-    // wall positions
-    glm::vec3 wallPositions[] = {
-            glm::vec3( -3.0f,  1.625f,  -2.525f),
-            glm::vec3( -5.425f, 1.625f, -1.2f),
-            glm::vec3( 2.5f, 1.125f, -2.025f),
-            glm::vec3( 3.925f, 1.125f, 0.05f)
-    };
-
-    // stairs - position and angle for every step
-    vector<pair<glm::vec3, float>> stairs = {
-            {glm::vec3( -0.3f,  0.5f,  2.0f), 0.0f},
-            {glm::vec3( -0.05f, 0.4f, 1.95f), 10.f},
-            {glm::vec3( 0.2f,  0.3f,  1.9f), 20.f},
-            {glm::vec3( 0.45f, 0.2f, 1.8f), 30.f}
-    };
-
-    // point light positions - light cubes
-    glm::vec3 pointLightPositions[] = {
-            glm::vec3( -0.2f,  0.6f,  2.6f),
-            glm::vec3( 0.0f, 0.5f, 1.3f)
-    };
-
-    // spotlight positions
-    glm::vec3 spotLightPositions[] = {
-            glm::vec3( -4.95f,  2.375f,  -1.6f),
-            glm::vec3( -4.8f,  2.375f,  -1.71f)
-    };
-
-    unsigned int platformVBO, platformVAO;
-    glGenVertexArrays(1, &platformVAO);
-    glGenBuffers(1, &platformVBO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, platformVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(platformVertices), platformVertices, GL_STATIC_DRAW);
-
-    glBindVertexArray(platformVAO);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-
-    unsigned int wallVBO, wallVAO;
-    glGenVertexArrays(1, &wallVAO);
-    glGenBuffers(1, &wallVBO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, wallVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(wallVertices), wallVertices, GL_STATIC_DRAW);
-
-    glBindVertexArray(wallVAO);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-
-    // light cube VAO
-    unsigned int lightCubeVAO;
-    glGenVertexArrays(1, &lightCubeVAO);
-    glBindVertexArray(lightCubeVAO);
-
-    glBindBuffer(GL_ARRAY_BUFFER, wallVBO);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    // load textures - using a utility function to keep the code more organized
-    unsigned int diffuseMapPlatform1 = loadTexture("resources/textures/WoodFlooringAshSuperWhite_diffuse.jpg");
-    unsigned int specularMapPlatform1 = loadTexture("resources/textures/WoodFlooringAshSuperWhite_specular.jpg");
-    unsigned int diffuseMapPlatform2 = loadTexture("resources/textures/TilesBlackSlateSquare_diffuse.png");
-    unsigned int specularMapPlatform2 = loadTexture("resources/textures/TilesBlackSlateSquare_specular.png");
-    unsigned int diffuseMapWall1 = loadTexture("resources/textures/BricksReclaimedWhitewashedOffset_diffuse.png");
-    unsigned int specularMapWall1 = loadTexture("resources/textures/BricksReclaimedWhitewashedOffset_specular.png");
-    unsigned int diffuseMapWall2 = loadTexture("resources/textures/StuccoRoughCast2_diffuse.png");
-    unsigned int specularMapWall2 = loadTexture("resources/textures/StuccoRoughCast_specular.png");
-    unsigned int diffuseMapGlass = loadTexture("resources/textures/glass1_diffuse.png");
-    unsigned int specularMapGlass = loadTexture("resources/textures/glass1_specular.png");
-
-    // load models
-    Model floorLampModel("resources/objects/FloorLamp/FloorLamp.obj");
-    floorLampModel.SetShaderTextureNamePrefix("material.");
-    Model armchairModel("resources/objects/Armchair/Armchair.obj");
-    armchairModel.SetShaderTextureNamePrefix("material.");
-    Model coffeeTableModel("resources/objects/CoffeeTable/CoffeeTableNimbusGoldReplica.obj");
-    coffeeTableModel.SetShaderTextureNamePrefix("material.");
-    Model rugRoundPatternModel("resources/objects/RugRoundPattern/RugRoundPattern.obj");
-    rugRoundPatternModel.SetShaderTextureNamePrefix("material.");
-    Model paintingModel("resources/objects/AbstractArt/AbstractArt.obj");
-    paintingModel.SetShaderTextureNamePrefix("material.");
-    Model rugRoundBluishModel("resources/objects/RugRoundBluish/RugRoundBluish.obj");
-    rugRoundBluishModel.SetShaderTextureNamePrefix("material.");
-    Model plantAgaveModel("resources/objects/PlantAgave/PlantAgave.obj");
-    plantAgaveModel.SetShaderTextureNamePrefix("material.");
-    Model trayModel("resources/objects/TrayRound/TrayRound.obj");
-    trayModel.SetShaderTextureNamePrefix("material.");
-
-    // shader configuration
-    platform1Shader.use();
-    platform1Shader.setInt("material.diffuse", 0);
-    platform1Shader.setInt("material.specular", 1);
-
-    platform2Shader.use();
-    platform2Shader.setInt("material.diffuse", 2);
-    platform2Shader.setInt("material.specular", 3);
-
-    wall1Shader.use();
-    wall1Shader.setInt("material.diffuse", 4);
-    wall1Shader.setInt("material.specular", 5);
-
-    wall2Shader.use();
-    wall2Shader.setInt("material.diffuse", 6);
-    wall2Shader.setInt("material.specular", 7);
-
-    stairsShader.use();
-    stairsShader.setInt("material.diffuse", 8);
-    stairsShader.setInt("material.specular", 9);
-
-
-    // directional light settings
-    glm::vec3 direction = glm::vec3(0.0f, -4.0f, -5.0f);
-    glm::vec3 dirLightAmbient = glm::vec3(0.05f, 0.05f, 0.05f);
-    glm::vec3 dirLightDiffuse = glm::vec3(0.4f, 0.4f, 0.4f);
-    glm::vec3 dirLightSpecular = glm::vec3(0.5f, 0.5f, 0.5f);
-
-    // point lights settings
-    glm::vec3 pointLightAmbient = glm::vec3(0.05f, 0.05f, 0.05f);
-    glm::vec3 pointLightDiffuse = glm::vec3(0.8f, 0.8f, 0.8f);
-    glm::vec3 pointLightSpecular = glm::vec3(1.0f, 1.0f, 1.0f);
-    float pointLightConstant = 1.0f;
-    float pointLightLinear = 0.09f;
-    float pointLightQuadratic = 0.032f;
-
-    // spotlights settings
-    glm::vec3 spotLightDirection = glm::vec3(0.0f,  -1.0f,  0.0f);
-    glm::vec3 spotLightAmbient = glm::vec3(0.0f, 0.0f, 0.0f);
-    glm::vec3 spotLightDiffuse = glm::vec3(0.6f, 0.6f, 0.6f);
-    glm::vec3 spotLightSpecular = glm::vec3(0.5f, 0.5f, 0.5f);
-    float spotLightConstant = 1.0f;
-    float spotLightLinear = 0.09f;
-    float spotLightQuadratic = 0.032f;
-    float cutOff = glm::cos(glm::radians(9.5f));
-    float outerCutOff = glm::cos(glm::radians(55.0f));
-
-    // draw in wireframe
-    //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-
-    // enabling blending to achieve transparency
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    // render loop
-    while (!glfwWindowShouldClose(window)) {
-
-        // per-frame time logic
-        float currentFrame = glfwGetTime();
-        deltaTime = currentFrame - lastFrame;
-        lastFrame = currentFrame;
-
-        // input
-        processInput(window);
-
-        // render
-        glClearColor(0.1, 0.1, 0.1, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-        // view/projection matrices
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom),
-                                                (float) SCR_WIDTH / (float) SCR_HEIGHT, 0.1f, 100.0f);
-        glm::mat4 view = camera.GetViewMatrix();
-        glm::mat4 model = glm::mat4(1.0f);
-
-        // enabling face culling for platforms and walls
-        glEnable(GL_CULL_FACE);
+    // everything that owns GL objects (shaders, buffers, models, textures) lives in this block, so their
+    // destructors run while the context still exists
+    {
+        // Leaving this comment here intentionally.
+        // tell stb_image.h to flip loaded texture's on the y-axis (before loading model)
+        // no - models in this project have textures with different texture origin
+    //    stbi_set_flip_vertically_on_load(true);
+
+        // configure global opengl state
+        glEnable(GL_DEPTH_TEST);
+        // face culling is switched on by the render queue for the draws submitted to RENDER_OPAQUE: everything but the
+        // glass stairs
         glFrontFace(GL_CCW);
         glCullFace(GL_BACK);
 
-        // =========================================== draw platforms ===========================================
-
-        // bind diffuse map
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, diffuseMapPlatform1);
-        // bind specular map
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, specularMapPlatform1);
-        // bind diffuse map
-        glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, diffuseMapPlatform2);
-        // bind specular map
-        glActiveTexture(GL_TEXTURE3);
-        glBindTexture(GL_TEXTURE_2D, specularMapPlatform2);
+        // with a scene pack (written by the asset_cooker tool) all models, textures and shaders below come out of one mapping,
+        // except for files changed since it was cooked
+        ScenePack::Instance().mount(SCENE_PACK_PATH);
+
+        // build and compile shaders
+        // camera and lights come out of uniform buffers, every program reads them from these binding points
+        BindUniformBlock("Camera", CAMERA_BLOCK_BINDING, sizeof(CameraBlock));
+        BindUniformBlock("Lights", LIGHTS_BLOCK_BINDING, sizeof(LightsBlock));
+        // the lit shaders are built for the scene's light counts (resources/shaders/lights.glsl). Shaders whose sources
+        // come out the same share one program: the platforms and walls all use one.
+        std::vector<std::string> lightDefines = {"NR_POINT_LIGHTS " + std::to_string(NUM_LIGHT_CUBES),
+                                                 "NR_SPOT_LIGHTS " + std::to_string(NUM_SPOT_LIGHTS)};
+        Shader platform1Shader("resources/shaders/platform1.vs", "resources/shaders/platform1.fs", lightDefines);
+        Shader platform2Shader("resources/shaders/platform2.vs", "resources/shaders/platform2.fs", lightDefines);
+        Shader wall1Shader("resources/shaders/wall1.vs", "resources/shaders/wall1.fs", lightDefines);
+        Shader wall2Shader("resources/shaders/wall2.vs", "resources/shaders/wall2.fs", lightDefines);
+        Shader stairsShader("resources/shaders/stairs.vs", "resources/shaders/stairs.fs", lightDefines);
+        Shader lightCubeShader("resources/shaders/lightCube.vs", "resources/shaders/lightCube.fs");
+        Shader modelShader("resources/shaders/model.vs", "resources/shaders/model.fs", lightDefines);
+        Shader *shaders[] = {&platform1Shader, &platform2Shader, &wall1Shader, &wall2Shader,
+                             &stairsShader, &lightCubeShader, &modelShader};
+        Uniform<glm::mat4> platform1Model = platform1Shader.uniform<glm::mat4>("model");
+        Uniform<glm::mat4> platform2Model = platform2Shader.uniform<glm::mat4>("model");
+        Uniform<glm::mat4> wall1Model = wall1Shader.uniform<glm::mat4>("model");
+        Uniform<glm::mat4> wall2Model = wall2Shader.uniform<glm::mat4>("model");
+        Uniform<glm::mat4> stairsModel = stairsShader.uniform<glm::mat4>("model");
+        Uniform<glm::mat4> modelModel = modelShader.uniform<glm::mat4>("model");
+        Uniform<glm::mat4> lightCubeModel = lightCubeShader.uniform<glm::mat4>("model");
+        // linked programs come from the binary cache after the first run
+        ProgramCache::Instance().report();
+
+        // basic cube vertices - to be used for drawing platforms
+        float platformVertices[] = {
+                // positions                // normals              //texture coords
+                // back face (CCW winding)
+                0.5f, -0.5f, -0.5f, 0.0f,  0.0f, -1.0f,  0.0f, 0.0f, // bottom-left
+                -0.5f, -0.5f, -0.5f, 0.0f,  0.0f, -1.0f, 4.0f, 0.0f, // bottom-right
+                -0.5f,  0.5f, -0.5f, 0.0f,  0.0f, -1.0f, 4.0f, 4.0f, // top-right
+                -0.5f,  0.5f, -0.5f, 0.0f,  0.0f, -1.0f, 4.0f, 4.0f, // top-right
+                0.5f,  0.5f, -0.5f, 0.0f,  0.0f, -1.0f, 0.0f, 4.0f, // top-left
+                0.5f, -0.5f, -0.5f, 0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
+                // front face (CCW winding)
+                -0.5f, -0.5f,  0.5f, 0.0f,  0.0f,  1.0f,  0.0f, 0.0f, // bottom-left
+                0.5f, -0.5f,  0.5f, 0.0f,  0.0f,  1.0f, 4.0f, 0.0f, // bottom-right
+                0.5f,  0.5f,  0.5f, 0.0f,  0.0f,  1.0f, 4.0f, 4.0f, // top-right
+                0.5f,  0.5f,  0.5f, 0.0f,  0.0f,  1.0f, 4.0f, 4.0f, // top-right
+                -0.5f,  0.5f,  0.5f, 0.0f,  0.0f,  1.0f, 0.0f, 4.0f, // top-left
+                -0.5f, -0.5f,  0.5f, 0.0f,  0.0f,  1.0f, 0.0f, 0.0f, // bottom-left
+                // left face (CCW)
+                -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-left
+                -0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f, 4.0f, 0.0f, // bottom-right
+                -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f, 4.0f, 4.0f, // top-right
+                -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f, 4.0f, 4.0f, // top-right
+                -0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f, 0.0f, 4.0f, // top-left
+                -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-left
+                // right face (CCW)
+                0.5f, -0.5f,  0.5f, 1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-left
+                0.5f, -0.5f, -0.5f, 1.0f,  0.0f,  0.0f, 4.0f, 0.0f, // bottom-right
+                0.5f,  0.5f, -0.5f, 1.0f,  0.0f,  0.0f, 4.0f, 4.0f, // top-right
+                0.5f,  0.5f, -0.5f, 1.0f,  0.0f,  0.0f, 4.0f, 4.0f, // top-right
+                0.5f,  0.5f,  0.5f, 1.0f,  0.0f,  0.0f, 0.0f, 4.0f, // top-left
+                0.5f, -0.5f,  0.5f, 1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-left
+                // bottom face (CCW)
+                -0.5f, -0.5f, -0.5f, 0.0f, -1.0f,  0.0f, 0.0f, 0.0f, // bottom-left
+                0.5f, -0.5f, -0.5f, 0.0f, -1.0f,  0.0f, 4.0f, 0.0f, // bottom-right
+                0.5f, -0.5f,  0.5f, 0.0f, -1.0f,  0.0f, 4.0f, 4.0f, // top-right
+                0.5f, -0.5f,  0.5f, 0.0f, -1.0f,  0.0f, 4.0f, 4.0f, // top-right
+                -0.5f, -0.5f,  0.5f, 0.0f, -1.0f,  0.0f, 0.0f, 4.0f, // top-left
+                -0.5f, -0.5f, -0.5f, 0.0f, -1.0f,  0.0f, 0.0f, 0.0f, // bottom-left
+                // top face (CCW)
+                -0.5f,  0.5f,  0.5f, 0.0f,  1.0f,  0.0f, 0.0f, 0.0f, // bottom-left
+                0.5f,  0.5f,  0.5f, 0.0f,  1.0f,  0.0f, 4.0f, 0.0f, // bottom-right
+                0.5f,  0.5f, -0.5f, 0.0f,  1.0f,  0.0f, 4.0f, 4.0f, // top-right
+                0.5f,  0.5f, -0.5f, 0.0f,  1.0f,  0.0f, 4.0f, 4.0f, // top-right
+                -0.5f,  0.5f, -0.5f, 0.0f,  1.0f,  0.0f, 0.0f, 4.0f, // top-left
+                -0.5f,  0.5f,  0.5f, 0.0f,  1.0f,  0.0f, 0.0f, 0.0f, // bottom-left
+        };
+
+        // basic cube vertices - to be used for drawing walls and light cubes
+        float wallVertices[] = {
+                // positions                // normals              //texture coords
+                // back face (CCW winding)
+                0.5f, -0.5f, -0.5f, 0.0f,  0.0f, -1.0f,  0.0f, 0.0f, // bottom-left
+                -0.5f, -0.5f, -0.5f, 0.0f,  0.0f, -1.0f, 1.0f, 0.0f, // bottom-right
+                -0.5f,  0.5f, -0.5f, 0.0f,  0.0f, -1.0f, 1.0f, 1.0f, // top-right
+                -0.5f,  0.5f, -0.5f, 0.0f,  0.0f, -1.0f, 1.0f, 1.0f, // top-right
+                0.5f,  0.5f, -0.5f, 0.0f,  0.0f, -1.0f, 0.0f, 1.0f, // top-left
+                0.5f, -0.5f, -0.5f, 0.0f,  0.0f, -1.0f, 0.0f, 0.0f, // bottom-left
+                // front face (CCW winding)
+                -0.5f, -0.5f,  0.5f, 0.0f,  0.0f,  1.0f,  0.0f, 0.0f, // bottom-left
+                0.5f, -0.5f,  0.5f, 0.0f,  0.0f,  1.0f, 1.0f, 0.0f, // bottom-right
+                0.5f,  0.5f,  0.5f, 0.0f,  0.0f,  1.0f, 1.0f, 1.0f, // top-right
+                0.5f,  0.5f,  0.5f, 0.0f,  0.0f,  1.0f, 1.0f, 1.0f, // top-right
+                -0.5f,  0.5f,  0.5f, 0.0f,  0.0f,  1.0f, 0.0f, 1.0f, // top-left
+                -0.5f, -0.5f,  0.5f, 0.0f,  0.0f,  1.0f, 0.0f, 0.0f, // bottom-left
+                // left face (CCW)
+                -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-left
+                -0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // bottom-right
+                -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-right
+                -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-right
+                -0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // top-left
+                -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-left
+                // right face (CCW)
+                0.5f, -0.5f,  0.5f, 1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-left
+                0.5f, -0.5f, -0.5f, 1.0f,  0.0f,  0.0f, 1.0f, 0.0f, // bottom-right
+                0.5f,  0.5f, -0.5f, 1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-right
+                0.5f,  0.5f, -0.5f, 1.0f,  0.0f,  0.0f, 1.0f, 1.0f, // top-right
+                0.5f,  0.5f,  0.5f, 1.0f,  0.0f,  0.0f, 0.0f, 1.0f, // top-left
+                0.5f, -0.5f,  0.5f, 1.0f,  0.0f,  0.0f, 0.0f, 0.0f, // bottom-left
+                // bottom face (CCW)
+                -0.5f, -0.5f, -0.5f, 0.0f, -1.0f,  0.0f, 0.0f, 0.0f, // bottom-left
+                0.5f, -0.5f, -0.5f, 0.0f, -1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
+                0.5f, -0.5f,  0.5f, 0.0f, -1.0f,  0.0f, 1.0f, 1.0f, // top-right
+                0.5f, -0.5f,  0.5f, 0.0f, -1.0f,  0.0f, 1.0f, 1.0f, // top-right
+                -0.5f, -0.5f,  0.5f, 0.0f, -1.0f,  0.0f, 0.0f, 1.0f, // top-left
+                -0.5f, -0.5f, -0.5f, 0.0f, -1.0f,  0.0f, 0.0f, 0.0f, // bottom-left
+                // top face (CCW)
+                -0.5f,  0.5f,  0.5f, 0.0f,  1.0f,  0.0f, 0.0f, 0.0f, // bottom-left
+                0.5f,  0.5f,  0.5f, 0.0f,  1.0f,  0.0f, 1.0f, 0.0f, // bottom-right
+                0.5f,  0.5f, -0.5f, 0.0f,  1.0f,  0.0f, 1.0f, 1.0f, // top-right
+                0.5f,  0.5f, -0.5f, 0.0f,  1.0f,  0.0f, 1.0f, 1.0f, // top-right
+                -0.5f,  0.5f, -0.5f, 0.0f,  1.0f,  0.0f, 0.0f, 1.0f, // top-left
+                -0.5f,  0.5f,  0.5f, 0.0f,  1.0f,  0.0f, 0.0f, 0.0f, // bottom-left
+        };
+
+        // platform positions
+        glm::vec3 platformPositions[] = {
+                glm::vec3( -3.0f,  0.5f,  0.0f),
+                glm::vec3( 1.5f, 0.0f, 0.5f)
+        };
+
+        // wall positions
+        glm::vec3 wallPositions[] = {
+                glm::vec3( -3.0f,  1.625f,  -2.525f),
+                glm::vec3( -5.425f, 1.625f, -1.2f),
+                glm::vec3( 2.5f, 1.125f, -2.025f),
+                glm::vec3( 3.925f, 1.125f, 0.05f)
+        };
+
+        // stairs - position and angle for every step
+        vector<pair<glm::vec3, float>> stairs = {
+                {glm::vec3( -0.3f,  0.5f,  2.0f), 0.0f},
+                {glm::vec3( -0.05f, 0.4f, 1.95f), 10.f},
+                {glm::vec3( 0.2f,  0.3f,  1.9f), 20.f},
+                {glm::vec3( 0.45f, 0.2f, 1.8f), 30.f}
+        };
+
+        // point light positions - light cubes
+        glm::vec3 pointLightPositions[] = {
+                glm::vec3( -0.2f,  0.6f,  2.6f),
+                glm::vec3( 0.0f, 0.5f, 1.3f)
+        };
+
+        // spotlight positions
+        glm::vec3 spotLightPositions[] = {
+                glm::vec3( -4.95f,  2.375f,  -1.6f),
+                glm::vec3( -4.8f,  2.375f,  -1.71f)
+        };
+
+        unsigned int platformVBO, platformVAO;
+        glGenVertexArrays(1, &platformVAO);
+        glGenBuffers(1, &platformVBO);
+
+        glBindBuffer(GL_ARRAY_BUFFER, platformVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(platformVertices), platformVertices, GL_STATIC_DRAW);
 
         glBindVertexArray(platformVAO);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+
+        unsigned int wallVBO, wallVAO;
+        glGenVertexArrays(1, &wallVAO);
+        glGenBuffers(1, &wallVBO);
 
-        // ------------------------------------------- first platform -------------------------------------------
-        platform1Shader.use();
-
-        platform1Shader.setVec3("viewPos", camera.Position);
-        platform1Shader.setFloat("material.shininess", 32.0f);
-
-        // directional light
-        platform1Shader.setVec3("dirLight.direction", direction);
-        platform1Shader.setVec3("dirLight.ambient", dirLightAmbient);
-        platform1Shader.setVec3("dirLight.diffuse", dirLightDiffuse);
-        platform1Shader.setVec3("dirLight.specular", dirLightSpecular);
-
-        // point light 1
-        platform1Shader.setVec3("pointLights[0].position",
-                                pointLightPositions[0] + glm::vec3(0.0f, 0.2 * sin(2 * glfwGetTime()), 0.0f));
-        platform1Shader.setVec3("pointLights[0].ambient", pointLightAmbient);
-        platform1Shader.setVec3("pointLights[0].diffuse", pointLightDiffuse);
-        platform1Shader.setVec3("pointLights[0].specular", pointLightSpecular);
-        platform1Shader.setFloat("pointLights[0].constant", pointLightConstant);
-        platform1Shader.setFloat("pointLights[0].linear", pointLightLinear);
-        platform1Shader.setFloat("pointLights[0].quadratic", pointLightQuadratic);
-        // point light 2
-        platform1Shader.setVec3("pointLights[1].position",
-                                pointLightPositions[1] + glm::vec3(0.0f, 0.2 * sin(2 * glfwGetTime() + 1), 0.0f));
-        platform1Shader.setVec3("pointLights[1].ambient", pointLightAmbient);
-        platform1Shader.setVec3("pointLights[1].diffuse", pointLightDiffuse);
-        platform1Shader.setVec3("pointLights[1].specular", pointLightSpecular);
-        platform1Shader.setFloat("pointLights[1].constant", pointLightConstant);
-        platform1Shader.setFloat("pointLights[1].linear", pointLightLinear);
-        platform1Shader.setFloat("pointLights[1].quadratic", pointLightQuadratic);
-
-        // spotlight 1
-        platform1Shader.setVec3("spotLights[0].position", spotLightPositions[0]);
-        platform1Shader.setVec3("spotLights[0].direction", spotLightDirection);
-        platform1Shader.setVec3("spotLights[0].ambient", spotLightAmbient);
-        platform1Shader.setVec3("spotLights[0].diffuse", spotLightDiffuse);
-        platform1Shader.setVec3("spotLights[0].specular", spotLightSpecular);
-        platform1Shader.setFloat("spotLights[0].constant", spotLightConstant);
-        platform1Shader.setFloat("spotLights[0].linear", spotLightLinear);
-        platform1Shader.setFloat("spotLights[0].quadratic", spotLightQuadratic);
-        platform1Shader.setFloat("spotLights[0].cutOff", cutOff);
-        platform1Shader.setFloat("spotLights[0].outerCutOff", outerCutOff);
-
-        // spotlight 2
-        platform1Shader.setVec3("spotLights[1].position", spotLightPositions[1]);
-        platform1Shader.setVec3("spotLights[1].direction", spotLightDirection);
-        platform1Shader.setVec3("spotLights[1].ambient", spotLightAmbient);
-        platform1Shader.setVec3("spotLights[1].diffuse", spotLightDiffuse);
-        platform1Shader.setVec3("spotLights[1].specular", spotLightSpecular);
-        platform1Shader.setFloat("spotLights[1].constant", spotLightConstant);
-        platform1Shader.setFloat("spotLights[1].linear", spotLightLinear);
-        platform1Shader.setFloat("spotLights[1].quadratic", spotLightQuadratic);
-        platform1Shader.setFloat("spotLights[1].cutOff", cutOff);
-        platform1Shader.setFloat("spotLights[1].outerCutOff", outerCutOff);
-
-        // view/projection transformations
-        platform1Shader.setMat4("projection", projection);
-        platform1Shader.setMat4("view", view);
-
-        // world transformation
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, platformPositions[0]);
-        model = glm::scale(model, glm::vec3(5.0f, 0.15f, 5.2f));
-        platform1Shader.setMat4("model", model);
-
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-
-        // ------------------------------------------- second platform -------------------------------------------
-        platform2Shader.use();
-
-        platform2Shader.setVec3("viewPos", camera.Position);
-        platform2Shader.setFloat("material.shininess", 32.0f);
-
-        // directional light
-        platform2Shader.setVec3("dirLight.direction", direction);
-        platform2Shader.setVec3("dirLight.ambient", dirLightAmbient);
-        platform2Shader.setVec3("dirLight.diffuse", dirLightDiffuse);
-        platform2Shader.setVec3("dirLight.specular", dirLightSpecular);
-
-        // point light 1
-        platform2Shader.setVec3("pointLights[0].position",
-                                pointLightPositions[0] + glm::vec3(0.0f, 0.2 * sin(2 * glfwGetTime()), 0.0f));
-        platform2Shader.setVec3("pointLights[0].ambient", pointLightAmbient);
-        platform2Shader.setVec3("pointLights[0].diffuse", pointLightDiffuse);
-        platform2Shader.setVec3("pointLights[0].specular", pointLightSpecular);
-        platform2Shader.setFloat("pointLights[0].constant", pointLightConstant);
-        platform2Shader.setFloat("pointLights[0].linear", pointLightLinear);
-        platform2Shader.setFloat("pointLights[0].quadratic", pointLightQuadratic);
-        // point light 2
-        platform2Shader.setVec3("pointLights[1].position",
-                                pointLightPositions[1] + glm::vec3(0.0f, 0.2 * sin(2 * glfwGetTime() + 1), 0.0f));
-        platform2Shader.setVec3("pointLights[1].ambient", pointLightAmbient);
-        platform2Shader.setVec3("pointLights[1].diffuse", pointLightDiffuse);
-        platform2Shader.setVec3("pointLights[1].specular", pointLightSpecular);
-        platform2Shader.setFloat("pointLights[1].constant", pointLightConstant);
-        platform2Shader.setFloat("pointLights[1].linear", pointLightLinear);
-        platform2Shader.setFloat("pointLights[1].quadratic", pointLightQuadratic);
-
-        // spotlight 1
-        platform2Shader.setVec3("spotLights[0].position", spotLightPositions[0]);
-        platform2Shader.setVec3("spotLights[0].direction", spotLightDirection);
-        platform2Shader.setVec3("spotLights[0].ambient", spotLightAmbient);
-        platform2Shader.setVec3("spotLights[0].diffuse", spotLightDiffuse);
-        platform2Shader.setVec3("spotLights[0].specular", spotLightSpecular);
-        platform2Shader.setFloat("spotLights[0].constant", spotLightConstant);
-        platform2Shader.setFloat("spotLights[0].linear", spotLightLinear);
-        platform2Shader.setFloat("spotLights[0].quadratic", spotLightQuadratic);
-        platform2Shader.setFloat("spotLights[0].cutOff", cutOff);
-        platform2Shader.setFloat("spotLights[0].outerCutOff", outerCutOff);
-
-        // spotlight 2
-        platform2Shader.setVec3("spotLights[1].position", spotLightPositions[1]);
-        platform2Shader.setVec3("spotLights[1].direction", spotLightDirection);
-        platform2Shader.setVec3("spotLights[1].ambient", spotLightAmbient);
-        platform2Shader.setVec3("spotLights[1].diffuse", spotLightDiffuse);
-        platform2Shader.setVec3("spotLights[1].specular", spotLightSpecular);
-        platform2Shader.setFloat("spotLights[1].constant", spotLightConstant);
-        platform2Shader.setFloat("spotLights[1].linear", spotLightLinear);
-        platform2Shader.setFloat("spotLights[1].quadratic", spotLightQuadratic);
-        platform2Shader.setFloat("spotLights[1].cutOff", cutOff);
-        platform2Shader.setFloat("spotLights[1].outerCutOff", outerCutOff);
-
-        // view/projection transformations
-        platform2Shader.setMat4("projection", projection);
-        platform2Shader.setMat4("view", view);
-
-        // world transformation
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, platformPositions[1]);
-        model = glm::scale(model, glm::vec3(5.0f, 0.15f, 5.2f));
-        platform2Shader.setMat4("model", model);
-
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-
-        // =========================================== platforms drawn ===========================================
-
-        // ============================================ draw models ==============================================
-        modelShader.use();
-
-        modelShader.setVec3("viewPos", camera.Position);
-        modelShader.setFloat("material.shininess", 32.0f);
-
-        // directional light
-        modelShader.setVec3("dirLight.direction", direction);
-        modelShader.setVec3("dirLight.ambient", dirLightAmbient);
-        modelShader.setVec3("dirLight.diffuse", dirLightDiffuse);
-        modelShader.setVec3("dirLight.specular", dirLightSpecular);
-
-        // point light 1
-        modelShader.setVec3("pointLights[0].position",
-                                pointLightPositions[0] + glm::vec3(0.0f, 0.2 * sin(2 * glfwGetTime()), 0.0f));
-        modelShader.setVec3("pointLights[0].ambient", pointLightAmbient);
-        modelShader.setVec3("pointLights[0].diffuse", pointLightDiffuse);
-        modelShader.setVec3("pointLights[0].specular", pointLightSpecular);
-        modelShader.setFloat("pointLights[0].constant", pointLightConstant);
-        modelShader.setFloat("pointLights[0].linear", pointLightLinear);
-        modelShader.setFloat("pointLights[0].quadratic", pointLightQuadratic);
-        // point light 2
-        modelShader.setVec3("pointLights[1].position",
-                                pointLightPositions[1] + glm::vec3(0.0f, 0.2 * sin(2 * glfwGetTime() + 1), 0.0f));
-        modelShader.setVec3("pointLights[1].ambient", pointLightAmbient);
-        modelShader.setVec3("pointLights[1].diffuse", pointLightDiffuse);
-        modelShader.setVec3("pointLights[1].specular", pointLightSpecular);
-        modelShader.setFloat("pointLights[1].constant", pointLightConstant);
-        modelShader.setFloat("pointLights[1].linear", pointLightLinear);
-        modelShader.setFloat("pointLights[1].quadratic", pointLightQuadratic);
-
-        // spotlight 1
-        modelShader.setVec3("spotLights[0].position", spotLightPositions[0]);
-        modelShader.setVec3("spotLights[0].direction", spotLightDirection);
-        modelShader.setVec3("spotLights[0].ambient", spotLightAmbient);
-        modelShader.setVec3("spotLights[0].diffuse", spotLightDiffuse);
-        modelShader.setVec3("spotLights[0].specular", spotLightSpecular);
-        modelShader.setFloat("spotLights[0].constant", spotLightConstant);
-        modelShader.setFloat("spotLights[0].linear", spotLightLinear);
-        modelShader.setFloat("spotLights[0].quadratic", spotLightQuadratic);
-        modelShader.setFloat("spotLights[0].cutOff", cutOff);
-        modelShader.setFloat("spotLights[0].outerCutOff", outerCutOff);
-
-        // spotlight 2
-        modelShader.setVec3("spotLights[1].position", spotLightPositions[1]);
-        modelShader.setVec3("spotLights[1].direction", spotLightDirection);
-        modelShader.setVec3("spotLights[1].ambient", spotLightAmbient);
-        modelShader.setVec3("spotLights[1].diffuse", spotLightDiffuse);
-        modelShader.setVec3("spotLights[1].specular", spotLightSpecular);
-        modelShader.setFloat("spotLights[1].constant", spotLightConstant);
-        modelShader.setFloat("spotLights[1].linear", spotLightLinear);
-        modelShader.setFloat("spotLights[1].quadratic", spotLightQuadratic);
-        modelShader.setFloat("spotLights[1].cutOff", cutOff);
-        modelShader.setFloat("spotLights[1].outerCutOff", outerCutOff);
-
-        // view/projection transformations
-        modelShader.setMat4("projection", projection);
-        modelShader.setMat4("view", view);
-
-        // ------------------------------------------- floorLampModel -------------------------------------------
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(-5.0f,  0.575f,  -1.8f));
-        model = glm::rotate(model, glm::radians(40.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        model = glm::scale(model, glm::vec3(0.8f, 0.8f, 0.8f));
-        modelShader.setMat4("model", model);
-        floorLampModel.Draw(modelShader);
-
-        // ------------------------------------------- armchairModel -------------------------------------------
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(-3.3f,  0.575f,  -1.6f));
-        model = glm::rotate(model, glm::radians(-105.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        model = glm::scale(model, glm::vec3(0.8f, 0.8f, 0.8f));
-        modelShader.setMat4("model", model);
-        armchairModel.Draw(modelShader);
-
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(-4.7f,  0.575f,  -0.95f));
-        model = glm::rotate(model, glm::radians(-30.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        model = glm::scale(model, glm::vec3(0.8f, 0.8f, 0.8f));
-        modelShader.setMat4("model", model);
-        armchairModel.Draw(modelShader);
-
-        // ------------------------------------------- coffeeTableModel -------------------------------------------
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(-4.2f,  0.575f,  -1.7f));
-        model = glm::scale(model, glm::vec3(1.0f, 1.0f, 1.0f));
-        modelShader.setMat4("model", model);
-        coffeeTableModel.Draw(modelShader);
-
-        // ------------------------------------------- rugRoundPatternModel ---------------------------------------
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(-3.65f,  0.58f,  -0.6f));
-        model = glm::scale(model, glm::vec3(1.0f, 1.0f, 1.0f));
-        modelShader.setMat4("model", model);
-        rugRoundPatternModel.Draw(modelShader);
-
-        // ------------------------------------------- paintingModel ---------------------------------------
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(3.85f,  1.2f,  -0.6f));
-        model = glm::rotate(model, glm::radians(-90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        model = glm::scale(model, glm::vec3(1.0f, 1.0f, 1.0f));
-        modelShader.setMat4("model", model);
-        paintingModel.Draw(modelShader);
-
-        // ------------------------------------------- rugRoundBluishModel ---------------------------------------
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(2.9f,  0.085f,  -0.9f));
-        model = glm::scale(model, glm::vec3(1.0f, 1.0f, 1.0f));
-        modelShader.setMat4("model", model);
-        rugRoundBluishModel.Draw(modelShader);
-
-        // ------------------------------------------- plantAgaveModel ---------------------------------------
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(3.5f,  0.085f,  -1.6f));
-        model = glm::scale(model, glm::vec3(1.0f, 1.0f, 1.0f));
-        modelShader.setMat4("model", model);
-        plantAgaveModel.Draw(modelShader);
-
-        // ------------------------------------------- trayModel ---------------------------------------
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(-4.2f,  0.937f,  -1.75f));
-        model = glm::scale(model, glm::vec3(1.0f, 1.0f, 1.0f));
-        modelShader.setMat4("model", model);
-        trayModel.Draw(modelShader);
-
-
-        // ============================================ models drawn ==============================================
-
-        // ============================================ draw light cubes ==========================================
-        lightCubeShader.use();
-
-        lightCubeShader.setMat4("projection", projection);
-        lightCubeShader.setMat4("view", view);
+        glBindBuffer(GL_ARRAY_BUFFER, wallVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(wallVertices), wallVertices, GL_STATIC_DRAW);
 
+        glBindVertexArray(wallVAO);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+
+        // light cube VAO
+        unsigned int lightCubeVAO;
+        glGenVertexArrays(1, &lightCubeVAO);
         glBindVertexArray(lightCubeVAO);
-        for (unsigned int i = 0; i < NUM_LIGHT_CUBES; i++)
+
+        glBindBuffer(GL_ARRAY_BUFFER, wallVBO);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+
+        // load textures - using a utility function to keep the code more organized
+        unsigned int diffuseMapPlatform1 = loadTexture("resources/textures/WoodFlooringAshSuperWhite_diffuse.jpg", TEXTURE_COLOR);
+        unsigned int specularMapPlatform1 = loadTexture("resources/textures/WoodFlooringAshSuperWhite_specular.jpg", TEXTURE_DATA);
+        unsigned int diffuseMapPlatform2 = loadTexture("resources/textures/TilesBlackSlateSquare_diffuse.png", TEXTURE_COLOR);
+        unsigned int specularMapPlatform2 = loadTexture("resources/textures/TilesBlackSlateSquare_specular.png", TEXTURE_DATA);
+        unsigned int diffuseMapWall1 = loadTexture("resources/textures/BricksReclaimedWhitewashedOffset_diffuse.png", TEXTURE_COLOR);
+        unsigned int specularMapWall1 = loadTexture("resources/textures/BricksReclaimedWhitewashedOffset_specular.png", TEXTURE_DATA);
+        unsigned int diffuseMapWall2 = loadTexture("resources/textures/StuccoRoughCast2_diffuse.png", TEXTURE_COLOR);
+        unsigned int specularMapWall2 = loadTexture("resources/textures/StuccoRoughCast_specular.png", TEXTURE_DATA);
+        unsigned int diffuseMapGlass = loadTexture("resources/textures/glass1_diffuse.png", TEXTURE_COLOR);
+        unsigned int specularMapGlass = loadTexture("resources/textures/glass1_specular.png", TEXTURE_DATA);
+        RenderMaterial platform1Material{diffuseMapPlatform1, specularMapPlatform1};
+        RenderMaterial platform2Material{diffuseMapPlatform2, specularMapPlatform2};
+        RenderMaterial wall1Material{diffuseMapWall1, specularMapWall1};
+        RenderMaterial wall2Material{diffuseMapWall2, specularMapWall2};
+        RenderMaterial glassMaterial{diffuseMapGlass, specularMapGlass};
+
+        // models - only their bounds are read here, the streamer loads each one in the background once the camera gets
+        // near it or sees it (see model_streamer.h)
+        ModelProxy floorLampModel("resources/objects/FloorLamp/FloorLamp.obj");
+        ModelProxy armchairModel("resources/objects/Armchair/Armchair.obj");
+        ModelProxy coffeeTableModel("resources/objects/CoffeeTable/CoffeeTableNimbusGoldReplica.obj");
+        ModelProxy rugRoundPatternModel("resources/objects/RugRoundPattern/RugRoundPattern.obj");
+        ModelProxy paintingModel("resources/objects/AbstractArt/AbstractArt.obj");
+        ModelProxy rugRoundBluishModel("resources/objects/RugRoundBluish/RugRoundBluish.obj");
+        ModelProxy plantAgaveModel("resources/objects/PlantAgave/PlantAgave.obj");
+        ModelProxy trayModel("resources/objects/TrayRound/TrayRound.obj");
+        ModelStreamer modelStreamer;
+        for (ModelProxy *proxy : {&floorLampModel, &armchairModel, &coffeeTableModel, &rugRoundPatternModel,
+                                  &paintingModel, &rugRoundBluishModel, &plantAgaveModel, &trayModel})
         {
-            model = glm::mat4(1.0f);
-            model = glm::translate(model, pointLightPositions[i] + glm::vec3(0.0f, 0.2 * sin(2 * glfwGetTime() + i), 0.0f));
-            model = glm::scale(model, glm::vec3(0.1f));
-            lightCubeShader.setMat4("model", model);
-            glDrawArrays(GL_TRIANGLES, 0, 36);
+            proxy->SetShaderTextureNamePrefix("material.");
+            modelStreamer.add(*proxy);
+        }
+        // edited models, materials, textures and shaders are reloaded while the viewer runs
+        FileWatcher fileWatcher;
+        fileWatcher.watch("resources/objects");
+        fileWatcher.watch("resources/shaders");
+
+        // shader configuration: diffuse maps are bound to unit 0 and specular maps to unit 1 before each draw, the
+        // shaders sharing a program share these settings as well
+        for (Shader *shader : {&platform1Shader, &platform2Shader, &wall1Shader, &wall2Shader, &stairsShader})
+        {
+            shader->use();
+            shader->setInt("material.diffuse", 0);
+            shader->setInt("material.specular", 1);
+        }
+        for (Shader *shader : {&platform1Shader, &platform2Shader, &wall1Shader, &wall2Shader, &stairsShader, &modelShader})
+        {
+            shader->use();
+            shader->setFloat("material.shininess", 32.0f);
         }
 
-        // ============================================ light cubes drawn =========================================
+        // directional light settings
+        glm::vec3 direction = glm::vec3(0.0f, -4.0f, -5.0f);
+        glm::vec3 dirLightAmbient = glm::vec3(0.05f, 0.05f, 0.05f);
+        glm::vec3 dirLightDiffuse = glm::vec3(0.4f, 0.4f, 0.4f);
+        glm::vec3 dirLightSpecular = glm::vec3(0.5f, 0.5f, 0.5f);
+
+        // point lights settings
+        glm::vec3 pointLightAmbient = glm::vec3(0.05f, 0.05f, 0.05f);
+        glm::vec3 pointLightDiffuse = glm::vec3(0.8f, 0.8f, 0.8f);
+        glm::vec3 pointLightSpecular = glm::vec3(1.0f, 1.0f, 1.0f);
+        float pointLightConstant = 1.0f;
+        float pointLightLinear = 0.09f;
+        float pointLightQuadratic = 0.032f;
+
+        // spotlights settings
+        glm::vec3 spotLightDirection = glm::vec3(0.0f,  -1.0f,  0.0f);
+        glm::vec3 spotLightAmbient = glm::vec3(0.0f, 0.0f, 0.0f);
+        glm::vec3 spotLightDiffuse = glm::vec3(0.6f, 0.6f, 0.6f);
+        glm::vec3 spotLightSpecular = glm::vec3(0.5f, 0.5f, 0.5f);
+        float spotLightConstant = 1.0f;
+        float spotLightLinear = 0.09f;
+        float spotLightQuadratic = 0.032f;
+        float cutOff = glm::cos(glm::radians(9.5f));
+        float outerCutOff = glm::cos(glm::radians(55.0f));
+
+        // draw in wireframe
+        //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+
+        // enabling blending to achieve transparency
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+        // the lights as the shaders read them, only the point light positions change from frame to frame
+        LightsBlock lights;
+        lights.dirLight = DirLightBlock{direction, 0.0f, dirLightAmbient, 0.0f, dirLightDiffuse, 0.0f, dirLightSpecular, 0.0f};
+        for (unsigned int i = 0; i < NUM_LIGHT_CUBES; i++)
+            lights.pointLights[i] = PointLightBlock{pointLightPositions[i], pointLightConstant, pointLightAmbient, pointLightLinear,
+                                                    pointLightDiffuse, pointLightQuadratic, pointLightSpecular, 0.0f};
+        for (unsigned int i = 0; i < NUM_SPOT_LIGHTS; i++)
+            lights.spotLights[i] = SpotLightBlock{spotLightPositions[i], cutOff, spotLightDirection, outerCutOff,
+                                                  spotLightAmbient, spotLightConstant, spotLightDiffuse, spotLightLinear,
+                                                  spotLightSpecular, spotLightQuadratic};
+        CameraBlock cameraBlock;
+        cameraBlock.padding = 0.0f;
+        UniformBufferRing frameUniforms(sizeof(CameraBlock) + sizeof(LightsBlock), 2);
+
+        // draws of a frame, issued sorted by state (see render_queue.h)
+        RenderQueue renderQueue;
+
+        // render loop
+        while (!glfwWindowShouldClose(window)) {
+
+            // per-frame time logic
+            float currentFrame = glfwGetTime();
+            deltaTime = currentFrame - lastFrame;
+            lastFrame = currentFrame;
+
+            // input
+            processInput(window);
+
+            // reload what changed on disk: textures in place (or into one of their own if they were shared with identical
+            // files), models imported in the background and swapped in later, shaders compiled by the driver and swapped
+            // in once linked
+            for (Shader *shader : shaders)
+                shader->update();
+            for (const std::string &path : fileWatcher.changes())
+            {
+                ScenePack::Instance().invalidate(path);
+                TextureRegistry::Instance().reload(path);
+                modelStreamer.reload(path);
+                for (Shader *shader : shaders)
+                    shader->reload(path);
+            }
+
+            // upload textures that finished decoding since the last frame
+            TextureLoader::Instance().update();
+
+            // render
+            glClearColor(0.1, 0.1, 0.1, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+            // view/projection matrices
+            float farPlane = 100.0f;
+            glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom),
+                                                    (float) SCR_WIDTH / (float) SCR_HEIGHT, 0.1f, farPlane);
+            glm::mat4 view = camera.GetViewMatrix();
+            glm::mat4 model = glm::mat4(1.0f);
+            // models pick their level of detail from their size on screen under this projection
+            LodView lodView(camera.Position, camera.Zoom, (float) SCR_HEIGHT);
+
+            // camera and lights for all shaders, the point lights move up and down with their light cubes
+            for (unsigned int i = 0; i < NUM_LIGHT_CUBES; i++)
+                lights.pointLights[i].position = pointLightPositions[i] + glm::vec3(0.0f, 0.2 * sin(2 * glfwGetTime() + i), 0.0f);
+            cameraBlock.projection = projection;
+            cameraBlock.view = view;
+            cameraBlock.viewPos = camera.Position;
+            frameUniforms.beginFrame();
+            frameUniforms.write(CAMERA_BLOCK_BINDING, cameraBlock);
+            frameUniforms.write(LIGHTS_BLOCK_BINDING, lights);
+
+            // the draws below are only collected: the queue sorts them by program, textures and vertex array, opaque
+            // ones front to back and transparent ones back to front, and issues them at the end
+            renderQueue.begin(camera.Position, farPlane);
+
+            // =========================================== platforms ================================================
+
+            // ------------------------------------------- first platform -------------------------------------------
+            model = glm::mat4(1.0f);
+            model = glm::translate(model, platformPositions[0]);
+            model = glm::scale(model, glm::vec3(5.0f, 0.15f, 5.2f));
+            renderQueue.submit(RENDER_OPAQUE, platform1Shader, platform1Model, model, &platform1Material, platformVAO, 36);
 
-        // =========================================== draw walls ================================================
+            // ------------------------------------------- second platform -------------------------------------------
+            model = glm::mat4(1.0f);
+            model = glm::translate(model, platformPositions[1]);
+            model = glm::scale(model, glm::vec3(5.0f, 0.15f, 5.2f));
+            renderQueue.submit(RENDER_OPAQUE, platform2Shader, platform2Model, model, &platform2Material, platformVAO, 36);
+
+            // ============================================ models ==================================================
+            // models that aren't loaded yet are only recorded for the streamer
+            auto submitModel = [&](ModelProxy &proxy, const glm::mat4 &model) {
+                if (Model *loaded = proxy.AddInstance(model))
+                    renderQueue.submit(RENDER_OPAQUE, modelShader, modelModel, model, *loaded, lodView);
+            };
+
+            // ------------------------------------------- floorLampModel -------------------------------------------
+            model = glm::mat4(1.0f);
+            model = glm::translate(model, glm::vec3(-5.0f,  0.575f,  -1.8f));
+            model = glm::rotate(model, glm::radians(40.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+            model = glm::scale(model, glm::vec3(0.8f, 0.8f, 0.8f));
+            submitModel(floorLampModel, model);
 
-        // bind diffuse map
-        glActiveTexture(GL_TEXTURE4);
-        glBindTexture(GL_TEXTURE_2D, diffuseMapWall1);
-        // bind specular map
-        glActiveTexture(GL_TEXTURE5);
-        glBindTexture(GL_TEXTURE_2D, specularMapWall1);
-        // bind diffuse map
-        glActiveTexture(GL_TEXTURE6);
-        glBindTexture(GL_TEXTURE_2D, diffuseMapWall2);
-        // bind specular map
-        glActiveTexture(GL_TEXTURE7);
-        glBindTexture(GL_TEXTURE_2D, specularMapWall2);
+            // ------------------------------------------- armchairModel -------------------------------------------
+            model = glm::mat4(1.0f);
+            model = glm::translate(model, glm::vec3(-3.3f,  0.575f,  -1.6f));
+            model = glm::rotate(model, glm::radians(-105.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+            model = glm::scale(model, glm::vec3(0.8f, 0.8f, 0.8f));
+            submitModel(armchairModel, model);
 
-        glBindVertexArray(wallVAO);
+            model = glm::mat4(1.0f);
+            model = glm::translate(model, glm::vec3(-4.7f,  0.575f,  -0.95f));
+            model = glm::rotate(model, glm::radians(-30.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+            model = glm::scale(model, glm::vec3(0.8f, 0.8f, 0.8f));
+            submitModel(armchairModel, model);
 
-        // ------------------------------------------- 1st wall --------------------------------------------------
-        wall1Shader.use();
-
-        wall1Shader.setVec3("viewPos", camera.Position);
-        wall1Shader.setFloat("material.shininess", 32.0f);
-
-        // directional light
-        wall1Shader.setVec3("dirLight.direction", direction);
-        wall1Shader.setVec3("dirLight.ambient", dirLightAmbient);
-        wall1Shader.setVec3("dirLight.diffuse", dirLightDiffuse);
-        wall1Shader.setVec3("dirLight.specular", dirLightSpecular);
-
-        // point light 1
-        wall1Shader.setVec3("pointLights[0].position",
-                            pointLightPositions[0] + glm::vec3(0.0f, 0.2 * sin(2 * glfwGetTime()), 0.0f));
-        wall1Shader.setVec3("pointLights[0].ambient", pointLightAmbient);
-        wall1Shader.setVec3("pointLights[0].diffuse", pointLightDiffuse);
-        wall1Shader.setVec3("pointLights[0].specular", pointLightSpecular);
-        wall1Shader.setFloat("pointLights[0].constant", pointLightConstant);
-        wall1Shader.setFloat("pointLights[0].linear", pointLightLinear);
-        wall1Shader.setFloat("pointLights[0].quadratic", pointLightQuadratic);
-        // point light 2
-        wall1Shader.setVec3("pointLights[1].position",
-                            pointLightPositions[1] + glm::vec3(0.0f, 0.2 * sin(2 * glfwGetTime() + 1), 0.0f));
-        wall1Shader.setVec3("pointLights[1].ambient", pointLightAmbient);
-        wall1Shader.setVec3("pointLights[1].diffuse", pointLightDiffuse);
-        wall1Shader.setVec3("pointLights[1].specular", pointLightSpecular);
-        wall1Shader.setFloat("pointLights[1].constant", pointLightConstant);
-        wall1Shader.setFloat("pointLights[1].linear", pointLightLinear);
-        wall1Shader.setFloat("pointLights[1].quadratic", pointLightQuadratic);
-
-        // spotlight 1
-        wall1Shader.setVec3("spotLights[0].position", spotLightPositions[0]);
-        wall1Shader.setVec3("spotLights[0].direction", spotLightDirection);
-        wall1Shader.setVec3("spotLights[0].ambient", spotLightAmbient);
-        wall1Shader.setVec3("spotLights[0].diffuse", spotLightDiffuse);
-        wall1Shader.setVec3("spotLights[0].specular", spotLightSpecular);
-        wall1Shader.setFloat("spotLights[0].constant", spotLightConstant);
-        wall1Shader.setFloat("spotLights[0].linear", spotLightLinear);
-        wall1Shader.setFloat("spotLights[0].quadratic", spotLightQuadratic);
-        wall1Shader.setFloat("spotLights[0].cutOff", cutOff);
-        wall1Shader.setFloat("spotLights[0].outerCutOff", outerCutOff);
-
-        // spotlight 2
-        wall1Shader.setVec3("spotLights[1].position", spotLightPositions[1]);
-        wall1Shader.setVec3("spotLights[1].direction", spotLightDirection);
-        wall1Shader.setVec3("spotLights[1].ambient", spotLightAmbient);
-        wall1Shader.setVec3("spotLights[1].diffuse", spotLightDiffuse);
-        wall1Shader.setVec3("spotLights[1].specular", spotLightSpecular);
-        wall1Shader.setFloat("spotLights[1].constant", spotLightConstant);
-        wall1Shader.setFloat("spotLights[1].linear", spotLightLinear);
-        wall1Shader.setFloat("spotLights[1].quadratic", spotLightQuadratic);
-        wall1Shader.setFloat("spotLights[1].cutOff", cutOff);
-        wall1Shader.setFloat("spotLights[1].outerCutOff", outerCutOff);
-
-        // view/projection transformations
-        wall1Shader.setMat4("projection", projection);
-        wall1Shader.setMat4("view", view);
-
-        // world transformation
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, wallPositions[0]);
-        model = glm::scale(model, glm::vec3(5.0f, 2.1f, 0.15f));
-        wall1Shader.setMat4("model", model);
-
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-
-        // ------------------------------------------- 2nd wall --------------------------------------------------
-        // uses the same shader as 1st wall
-        // world transformation
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, wallPositions[1]);
-        model = glm::rotate(model, glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        model = glm::scale(model, glm::vec3(2.5f, 2.1f, 0.15f));
-        wall1Shader.setMat4("model", model);
-
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-
-        // ------------------------------------------- 3rd wall --------------------------------------------------
-        wall2Shader.use();
-
-        wall2Shader.setVec3("viewPos", camera.Position);
-        wall2Shader.setFloat("material.shininess", 32.0f);
-
-        // directional light
-        wall2Shader.setVec3("dirLight.direction", direction);
-        wall2Shader.setVec3("dirLight.ambient", dirLightAmbient);
-        wall2Shader.setVec3("dirLight.diffuse", dirLightDiffuse);
-        wall2Shader.setVec3("dirLight.specular", dirLightSpecular);
-
-        // point light 1
-        wall2Shader.setVec3("pointLights[0].position",
-                            pointLightPositions[0] + glm::vec3(0.0f, 0.2 * sin(2 * glfwGetTime()), 0.0f));
-        wall2Shader.setVec3("pointLights[0].ambient", pointLightAmbient);
-        wall2Shader.setVec3("pointLights[0].diffuse", pointLightDiffuse);
-        wall2Shader.setVec3("pointLights[0].specular", pointLightSpecular);
-        wall2Shader.setFloat("pointLights[0].constant", pointLightConstant);
-        wall2Shader.setFloat("pointLights[0].linear", pointLightLinear);
-        wall2Shader.setFloat("pointLights[0].quadratic", pointLightQuadratic);
-        // point light 2
-        wall2Shader.setVec3("pointLights[1].position",
-                            pointLightPositions[1] + glm::vec3(0.0f, 0.2 * sin(2 * glfwGetTime() + 1), 0.0f));
-        wall2Shader.setVec3("pointLights[1].ambient", pointLightAmbient);
-        wall2Shader.setVec3("pointLights[1].diffuse", pointLightDiffuse);
-        wall2Shader.setVec3("pointLights[1].specular", pointLightSpecular);
-        wall2Shader.setFloat("pointLights[1].constant", pointLightConstant);
-        wall2Shader.setFloat("pointLights[1].linear", pointLightLinear);
-        wall2Shader.setFloat("pointLights[1].quadratic", pointLightQuadratic);
-
-        // spotlight 1
-        wall2Shader.setVec3("spotLights[0].position", spotLightPositions[0]);
-        wall2Shader.setVec3("spotLights[0].direction", spotLightDirection);
-        wall2Shader.setVec3("spotLights[0].ambient", spotLightAmbient);
-        wall2Shader.setVec3("spotLights[0].diffuse", spotLightDiffuse);
-        wall2Shader.setVec3("spotLights[0].specular", spotLightSpecular);
-        wall2Shader.setFloat("spotLights[0].constant", spotLightConstant);
-        wall2Shader.setFloat("spotLights[0].linear", spotLightLinear);
-        wall2Shader.setFloat("spotLights[0].quadratic", spotLightQuadratic);
-        wall2Shader.setFloat("spotLights[0].cutOff", cutOff);
-        wall2Shader.setFloat("spotLights[0].outerCutOff", outerCutOff);
-
-        // spotlight 2
-        wall2Shader.setVec3("spotLights[1].position", spotLightPositions[1]);
-        wall2Shader.setVec3("spotLights[1].direction", spotLightDirection);
-        wall2Shader.setVec3("spotLights[1].ambient", spotLightAmbient);
-        wall2Shader.setVec3("spotLights[1].diffuse", spotLightDiffuse);
-        wall2Shader.setVec3("spotLights[1].specular", spotLightSpecular);
-        wall2Shader.setFloat("spotLights[1].constant", spotLightConstant);
-        wall2Shader.setFloat("spotLights[1].linear", spotLightLinear);
-        wall2Shader.setFloat("spotLights[1].quadratic", spotLightQuadratic);
-        wall2Shader.setFloat("spotLights[1].cutOff", cutOff);
-        wall2Shader.setFloat("spotLights[1].outerCutOff", outerCutOff);
-
-        // view/projection transformations
-        wall2Shader.setMat4("projection", projection);
-        wall2Shader.setMat4("view", view);
-
-        // world transformation
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, wallPositions[2]);
-        model = glm::scale(model, glm::vec3(3.0f, 2.1f, 0.15f));
-        wall2Shader.setMat4("model", model);
-
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-
-        // ------------------------------------------- 4th wall --------------------------------------------------
-        // uses the same shader as 3rd wall
-        // world transformation
-        model = glm::mat4(1.0f);
-        model = glm::translate(model, wallPositions[3]);
-        model = glm::rotate(model, glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
-        model = glm::scale(model, glm::vec3(4.0f, 2.1f, 0.15f));
-        wall2Shader.setMat4("model", model);
-
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-
-        // =========================================== walls drawn ===============================================
-
-        // I don't want face culling for anything other than platforms and walls
-        glDisable(GL_CULL_FACE);
-
-        // =========================================== draw glass stairs =========================================
-        // using wallVBO & wallVAO
-
-        // bind diffuse map
-        glActiveTexture(GL_TEXTURE8);
-        glBindTexture(GL_TEXTURE_2D, diffuseMapGlass);
-        // bind specular map
-        glActiveTexture(GL_TEXTURE9);
-        glBindTexture(GL_TEXTURE_2D, specularMapGlass);
-
-        stairsShader.use();
-
-        stairsShader.setVec3("viewPos", camera.Position);
-        stairsShader.setFloat("material.shininess", 32.0f);
-
-        // directional light
-        stairsShader.setVec3("dirLight.direction", direction);
-        stairsShader.setVec3("dirLight.ambient", dirLightAmbient);
-        stairsShader.setVec3("dirLight.diffuse", dirLightDiffuse);
-        stairsShader.setVec3("dirLight.specular", dirLightSpecular);
-
-        // point light 1
-        stairsShader.setVec3("pointLights[0].position",
-                             pointLightPositions[0] + glm::vec3(0.0f, 0.2 * sin(2 * glfwGetTime()), 0.0f));
-        stairsShader.setVec3("pointLights[0].ambient", pointLightAmbient);
-        stairsShader.setVec3("pointLights[0].diffuse", pointLightDiffuse);
-        stairsShader.setVec3("pointLights[0].specular", pointLightSpecular);
-        stairsShader.setFloat("pointLights[0].constant", pointLightConstant);
-        stairsShader.setFloat("pointLights[0].linear", pointLightLinear);
-        stairsShader.setFloat("pointLights[0].quadratic", pointLightQuadratic);
-        // point light 2
-        stairsShader.setVec3("pointLights[1].position",
-                             pointLightPositions[1] + glm::vec3(0.0f, 0.2 * sin(2 * glfwGetTime() + 1), 0.0f));
-        stairsShader.setVec3("pointLights[1].ambient", pointLightAmbient);
-        stairsShader.setVec3("pointLights[1].diffuse", pointLightDiffuse);
-        stairsShader.setVec3("pointLights[1].specular", pointLightSpecular);
-        stairsShader.setFloat("pointLights[1].constant", pointLightConstant);
-        stairsShader.setFloat("pointLights[1].linear", pointLightLinear);
-        stairsShader.setFloat("pointLights[1].quadratic", pointLightQuadratic);
-
-        // spotlight 1
-        stairsShader.setVec3("spotLights[0].position", spotLightPositions[0]);
-        stairsShader.setVec3("spotLights[0].direction", spotLightDirection);
-        stairsShader.setVec3("spotLights[0].ambient", spotLightAmbient);
-        stairsShader.setVec3("spotLights[0].diffuse", spotLightDiffuse);
-        stairsShader.setVec3("spotLights[0].specular", spotLightSpecular);
-        stairsShader.setFloat("spotLights[0].constant", spotLightConstant);
-        stairsShader.setFloat("spotLights[0].linear", spotLightLinear);
-        stairsShader.setFloat("spotLights[0].quadratic", spotLightQuadratic);
-        stairsShader.setFloat("spotLights[0].cutOff", cutOff);
-        stairsShader.setFloat("spotLights[0].outerCutOff", outerCutOff);
-
-        // spotlight 2
-        stairsShader.setVec3("spotLights[1].position", spotLightPositions[1]);
-        stairsShader.setVec3("spotLights[1].direction", spotLightDirection);
-        stairsShader.setVec3("spotLights[1].ambient", spotLightAmbient);
-        stairsShader.setVec3("spotLights[1].diffuse", spotLightDiffuse);
-        stairsShader.setVec3("spotLights[1].specular", spotLightSpecular);
-        stairsShader.setFloat("spotLights[1].constant", spotLightConstant);
-        stairsShader.setFloat("spotLights[1].linear", spotLightLinear);
-        stairsShader.setFloat("spotLights[1].quadratic", spotLightQuadratic);
-        stairsShader.setFloat("spotLights[1].cutOff", cutOff);
-        stairsShader.setFloat("spotLights[1].outerCutOff", outerCutOff);
-
-        // view/projection transformations
-        stairsShader.setMat4("projection", projection);
-        stairsShader.setMat4("view", view);
-
-        // steps need to be sorted because of their transparency - if rendered differently
-        // some steps may not be visible through the other ones
-        std::sort(stairs.begin(), stairs.end(),
-                  [cameraPosition = camera.Position](const pair<glm::vec3, float>& a, const pair<glm::vec3, float>& b) {
-                      float d1 = glm::distance(a.first, cameraPosition);
-                      float d2 = glm::distance(b.first, cameraPosition);
-                      return d1 > d2;
-        });
-
-        for (const pair<glm::vec3, float>& step : stairs) {
+            // ------------------------------------------- coffeeTableModel -------------------------------------------
             model = glm::mat4(1.0f);
-            model = glm::translate(model, step.first);
-            model = glm::rotate(model, glm::radians(step.second), glm::vec3(0.0f, 1.0f, 0.0f));
-            model = glm::scale(model, glm::vec3(0.25f, 0.05f, 0.75f));
-            stairsShader.setMat4("model", model);
-            glDrawArrays(GL_TRIANGLES, 0, 36);
-        }
+            model = glm::translate(model, glm::vec3(-4.2f,  0.575f,  -1.7f));
+            model = glm::scale(model, glm::vec3(1.0f, 1.0f, 1.0f));
+            submitModel(coffeeTableModel, model);
+
+            // ------------------------------------------- rugRoundPatternModel ---------------------------------------
+            model = glm::mat4(1.0f);
+            model = glm::translate(model, glm::vec3(-3.65f,  0.58f,  -0.6f));
+            model = glm::scale(model, glm::vec3(1.0f, 1.0f, 1.0f));
+            submitModel(rugRoundPatternModel, model);
+
+            // ------------------------------------------- paintingModel ---------------------------------------
+            model = glm::mat4(1.0f);
+            model = glm::translate(model, glm::vec3(3.85f,  1.2f,  -0.6f));
+            model = glm::rotate(model, glm::radians(-90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+            model = glm::scale(model, glm::vec3(1.0f, 1.0f, 1.0f));
+            submitModel(paintingModel, model);
+
+            // ------------------------------------------- rugRoundBluishModel ---------------------------------------
+            model = glm::mat4(1.0f);
+            model = glm::translate(model, glm::vec3(2.9f,  0.085f,  -0.9f));
+            model = glm::scale(model, glm::vec3(1.0f, 1.0f, 1.0f));
+            submitModel(rugRoundBluishModel, model);
+
+            // ------------------------------------------- plantAgaveModel ---------------------------------------
+            model = glm::mat4(1.0f);
+            model = glm::translate(model, glm::vec3(3.5f,  0.085f,  -1.6f));
+            model = glm::scale(model, glm::vec3(1.0f, 1.0f, 1.0f));
+            submitModel(plantAgaveModel, model);
+
+            // ------------------------------------------- trayModel ---------------------------------------
+            model = glm::mat4(1.0f);
+            model = glm::translate(model, glm::vec3(-4.2f,  0.937f,  -1.75f));
+            model = glm::scale(model, glm::vec3(1.0f, 1.0f, 1.0f));
+            submitModel(trayModel, model);
+
+            // ============================================ light cubes =============================================
+            for (unsigned int i = 0; i < NUM_LIGHT_CUBES; i++)
+            {
+                model = glm::mat4(1.0f);
+                model = glm::translate(model, lights.pointLights[i].position);
+                model = glm::scale(model, glm::vec3(0.1f));
+                renderQueue.submit(RENDER_OPAQUE, lightCubeShader, lightCubeModel, model, nullptr, lightCubeVAO, 36);
+            }
+
+            // =========================================== walls ====================================================
+
+            // ------------------------------------------- 1st wall --------------------------------------------------
+            model = glm::mat4(1.0f);
+            model = glm::translate(model, wallPositions[0]);
+            model = glm::scale(model, glm::vec3(5.0f, 2.1f, 0.15f));
+            renderQueue.submit(RENDER_OPAQUE, wall1Shader, wall1Model, model, &wall1Material, wallVAO, 36);
 
-        // =========================================== glass stairs drawn =========================================
+            // ------------------------------------------- 2nd wall --------------------------------------------------
+            model = glm::mat4(1.0f);
+            model = glm::translate(model, wallPositions[1]);
+            model = glm::rotate(model, glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+            model = glm::scale(model, glm::vec3(2.5f, 2.1f, 0.15f));
+            renderQueue.submit(RENDER_OPAQUE, wall1Shader, wall1Model, model, &wall1Material, wallVAO, 36);
 
+            // ------------------------------------------- 3rd wall --------------------------------------------------
+            model = glm::mat4(1.0f);
+            model = glm::translate(model, wallPositions[2]);
+            model = glm::scale(model, glm::vec3(3.0f, 2.1f, 0.15f));
+            renderQueue.submit(RENDER_OPAQUE, wall2Shader, wall2Model, model, &wall2Material, wallVAO, 36);
 
-        // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+            // ------------------------------------------- 4th wall --------------------------------------------------
+            model = glm::mat4(1.0f);
+            model = glm::translate(model, wallPositions[3]);
+            model = glm::rotate(model, glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+            model = glm::scale(model, glm::vec3(4.0f, 2.1f, 0.15f));
+            renderQueue.submit(RENDER_OPAQUE, wall2Shader, wall2Model, model, &wall2Material, wallVAO, 36);
+
+            // =========================================== glass stairs =============================================
+            // using wallVBO & wallVAO, transparent: the queue draws the steps back to front so every step can be seen
+            // through the ones before it
+            for (const pair<glm::vec3, float>& step : stairs) {
+                model = glm::mat4(1.0f);
+                model = glm::translate(model, step.first);
+                model = glm::rotate(model, glm::radians(step.second), glm::vec3(0.0f, 1.0f, 0.0f));
+                model = glm::scale(model, glm::vec3(0.25f, 0.05f, 0.75f));
+                renderQueue.submit(RENDER_TRANSPARENT, stairsShader, stairsModel, model, &glassMaterial, wallVAO, 36);
+            }
+
+            renderQueue.execute();
+
+
+            // load the models that came into reach this frame, unload far away ones if memory runs short
+            modelStreamer.update(projection * view, camera.Position);
+
+            // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
+            glfwSwapBuffers(window);
+            glfwPollEvents();
+        }
     }
 
     // glfw: terminate, clearing all previously allocated GLFW resources.
@@ -991,39 +703,9 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action, int mod
 }
 
 // utility function for loading a 2D texture from file
-unsigned int loadTexture(char const * path)
+// the texture name is returned right away, decoding happens in the background (see TextureLoader).
+// shared with the models through the TextureRegistry, an image used by both is loaded once.
+unsigned int loadTexture(char const * path, Texture_Usage usage)
 {
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
-
-    int width, height, nrComponents;
-    unsigned char *data = stbi_load(path, &width, &height, &nrComponents, 0);
-    if (data)
-    {
-        GLenum format;
-        if (nrComponents == 1)
-            format = GL_RED;
-        else if (nrComponents == 3)
-            format = GL_RGB;
-        else if (nrComponents == 4)
-            format = GL_RGBA;
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    }
-    else
-    {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
+    return TextureRegistry::Instance().acquire(path, usage);
 }
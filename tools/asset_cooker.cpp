@@ -0,0 +1,162 @@
+// Offline asset cooker: does all conversion work ahead of time, so the viewer starts from cooked data.
+//
+//     asset_cooker [--no-s3tc] [--threads N] [resource directory, default resources]
+//
+// Walks the resource directory. It imports and optimizes every model into its mesh cache, gives every texture its
+// mip chain and block compression in a .ktx, and packs all of it together with the shaders into the scene pack the
+// viewer maps at startup (see scene_pack.h). Run it from the project root, like the viewer, so the paths match.
+//
+// Outputs are keyed by the content hash of their source and the cook settings (import flags, texture usage, s3tc,
+// format versions): an asset is rebuilt only when one of them changes. For every asset the cooker prints the cold
+// time (import or conversion, when it had to be rebuilt) and the warm time (loading the cooked output).
+
+#include <learnopengl/scene_pack_cooker.h>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static std::string Lowercase(std::string str)
+{
+    for (char &c : str)
+        c = (char)std::tolower((unsigned char)c);
+    return str;
+}
+
+static bool HasFileExtension(const std::string &path, const std::vector<const char*> &extensions)
+{
+    std::string lower = Lowercase(path);
+    for (const char *extension : extensions)
+    {
+        size_t length = strlen(extension);
+        if (lower.size() > length && lower.compare(lower.size() - length, length, extension) == 0)
+            return true;
+    }
+    return false;
+}
+
+// usage of an image no material refers to (main.cpp loads those itself), going by the usual file name suffixes.
+// Material textures get theirs from the material, which wins over this guess.
+static Texture_Usage GuessTextureUsage(const std::string &path)
+{
+    std::string name = Lowercase(path.substr(path.find_last_of('/') + 1));
+    if (name.find("nrm") != std::string::npos || name.find("normal") != std::string::npos)
+        return TEXTURE_NORMAL;
+    for (const char *data : {"spec", "rough", "metal", "gloss", "_ao", "height", "disp"})
+        if (name.find(data) != std::string::npos)
+            return TEXTURE_DATA;
+    return TEXTURE_COLOR;
+}
+
+// every file below directory, hidden ones skipped
+static void ListFiles(const std::string &directory, std::vector<std::string> &files)
+{
+    DIR *dir = opendir(directory.c_str());
+    if (!dir)
+        return;
+    while (dirent *entry = readdir(dir))
+    {
+        if (entry->d_name[0] == '.')
+            continue;
+        std::string path = directory + '/' + entry->d_name;
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0)
+            continue;
+        if (S_ISDIR(st.st_mode))
+            ListFiles(path, files);
+        else if (S_ISREG(st.st_mode))
+            files.push_back(path);
+    }
+    closedir(dir);
+}
+
+static const char *KindName(Pack_Entry_Kind kind)
+{
+    switch (kind)
+    {
+        case PACK_MESHES: return "model";
+        case PACK_TEXTURE: return "texture";
+        default: return "shader";
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    bool s3tc = true;
+    unsigned int threadCount = 0;
+    std::string root = "resources";
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--no-s3tc")
+            s3tc = false;
+        else if (arg == "--threads" && i + 1 < argc)
+            threadCount = std::atoi(argv[++i]);
+        else if (!arg.empty() && arg[0] == '-')
+        {
+            std::cout << "usage: " << argv[0] << " [--no-s3tc] [--threads N] [resource directory]" << std::endl;
+            return 1;
+        }
+        else
+            root = arg;
+    }
+
+    std::vector<std::string> files;
+    ListFiles(root, files);
+    std::sort(files.begin(), files.end());
+    ScenePackSources sources;
+    for (const std::string &file : files)
+    {
+        if (HasFileExtension(file, {".obj", ".fbx", ".gltf", ".glb", ".dae", ".3ds"}))
+            sources.models.push_back(file);
+        else if (HasFileExtension(file, {".jpg", ".jpeg", ".png", ".tga", ".bmp"}))
+            sources.textures.push_back(std::make_pair(file, GuessTextureUsage(file)));
+        else if (HasFileExtension(file, {".vs", ".fs", ".gs", ".glsl"}))
+            sources.shaders.push_back(file);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<CookedAsset> assets;
+    bool written;
+    {
+        ThreadPool encoders(threadCount);
+        ThreadPool pool(threadCount);
+        written = CookScenePack(SCENE_PACK_PATH, sources, s3tc, pool, encoders, assets);
+    }
+    double totalMs = CookMilliseconds(start);
+
+    unsigned int rebuilt = 0, failed = 0;
+    double coldMs = 0.0, warmMs = 0.0;
+    for (const CookedAsset &asset : assets)
+    {
+        char line[64];
+        if (!asset.cooked)
+        {
+            failed++;
+            snprintf(line, sizeof(line), "%-8s %-10s", KindName(asset.kind), "FAILED");
+        }
+        else if (asset.rebuilt)
+        {
+            rebuilt++;
+            snprintf(line, sizeof(line), "%-8s cold %9.1f ms, warm %7.1f ms", KindName(asset.kind), asset.cookMs, asset.loadMs);
+        }
+        else
+            snprintf(line, sizeof(line), "%-8s up to date,      warm %7.1f ms", KindName(asset.kind), asset.loadMs);
+        coldMs += asset.cookMs;
+        warmMs += asset.loadMs;
+        std::cout << line << "  " << asset.path << std::endl;
+    }
+    std::cout << "AssetCooker: " << assets.size() << " assets, " << rebuilt << " rebuilt, " << failed << " failed, cold "
+              << (long)coldMs << " ms, warm " << (long)warmMs << " ms (summed over threads), total " << (long)totalMs
+              << " ms" << std::endl;
+    return written && failed == 0 ? 0 : 1;
+}